@@ -0,0 +1,176 @@
+#include "animation.hpp"
+#include <fstream>
+#include <thread>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "meerkat_stopwatch.hpp"
+#include "meerkat_table_writer.hpp"
+
+Animation::Animation(const Job &base_, std::string output_)
+{
+    _log.tag("Animation");
+    _base = base_;
+    // frames would overwrite each other's checkpoints
+    _base.checkpoint = "";
+    _output = output_;
+}
+
+bool Animation::read_frames(std::string list_)
+{
+    std::ifstream f(list_.c_str());
+    if( !f )
+    {
+        _log.e("read_frames", "could not read list of frames");
+        return false;
+    }
+
+    std::string line;
+    _frames.clear();
+    while( std::getline(f, line) )
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if( first == std::string::npos || line[first] == '#' )
+            continue;
+        size_t last = line.find_last_not_of(" \t\r");
+
+        Frame frame;
+        frame.job = _base;
+        frame.job.edges = line.substr(first, last-first+1);
+        // frame indices are inserted before the extension
+        char index[16];
+        sprintf(index, "_%04d", (int)_frames.size());
+        frame.job.set_output(Job::output_name(_output, index));
+        frame.read = frame.ok = false;
+        frame.edgesNum = frame.continuedNum = 0;
+        frame.readTime = frame.bundleTime = frame.writeTime = 0.0;
+        _frames.push_back(frame);
+    }
+    if( _frames.empty() )
+    {
+        _log.e("read_frames", "no frames found");
+        return false;
+    }
+    _log.i("read_frames", "number of frames: %i", (int)_frames.size());
+    return true;
+}
+
+void Animation::read_frame(int frame_, Graph *graph_, int threadsNum_)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(threadsNum_);
+#endif
+    Frame &frame = _frames[frame_];
+    meerkat::mk_stopwatch stopwatch;
+    frame.job.configure(*graph_);
+    // only the first frame builds its compatibility lists from scratch
+    if( frame_ == 0 )
+        frame.read = frame.job.read(*graph_);
+    else
+        frame.read = graph_->read(frame.job.nodes, frame.job.edges, false);
+    frame.readTime = stopwatch.seconds();
+    if( !frame.read )
+        _log.w("read_frame", "frame %d could not be read", frame_);
+}
+
+void Animation::prepare_frame(int frame_, Graph *graph_, const Graph *previous_)
+{
+    Frame &frame = _frames[frame_];
+    meerkat::mk_stopwatch stopwatch;
+    if( previous_ != NULL && _frames[frame_-1].read )
+        frame.continuedNum = graph_->follow(*previous_, frame.job.warmCycles);
+    else if( !graph_->compatibility_lists() )
+        graph_->build_compatibility_lists();
+    frame.edgesNum = (int)graph_->edges().size();
+    frame.bundleTime += stopwatch.seconds();
+}
+
+void Animation::bundle_frame(int frame_, Graph *graph_)
+{
+    meerkat::mk_stopwatch stopwatch;
+    graph_->run();
+    _frames[frame_].bundleTime += stopwatch.seconds();
+}
+
+void Animation::write_frame(int frame_, Graph *graph_, int threadsNum_)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(threadsNum_);
+#endif
+    Frame &frame = _frames[frame_];
+    meerkat::mk_stopwatch stopwatch;
+    frame.ok = frame.job.finish(*graph_);
+    frame.writeTime = stopwatch.seconds();
+    if( !frame.ok )
+        _log.w("write_frame", "frame %d could not be written", frame_);
+}
+
+int Animation::run()
+{
+    int framesNum = (int)_frames.size();
+    int threadsNum = 1;
+#ifdef _OPENMP
+    threadsNum = omp_get_max_threads();
+#endif
+
+    // the graph of a frame is reused three frames later, only the first frame is read
+    // with progress logs
+    meerkat::mk_stopwatch stopwatch;
+    std::vector<Graph> graphs(3);
+    read_frame(0, &graphs[0], threadsNum);
+    _log.i("run", "bundling %d frames", framesNum);
+    for( int g=0; g<3; g++ )
+        graphs[g].set_severity_level(meerkat::mk_log::SLWarning);
+    for( int f=0; f<framesNum; f++ )
+    {
+        Graph *graph = &graphs[f%3];
+        if( _frames[f].read )
+            prepare_frame(f, graph, f > 0 ? &graphs[(f-1)%3] : NULL);
+
+        // the previous frame is written once the current one continued from it, reading
+        // and writing use a single thread to leave the cores to the iterations
+        std::thread writer, reader;
+        if( f > 0 && _frames[f-1].read )
+            writer = std::thread(&Animation::write_frame, this, f-1, &graphs[(f-1)%3], 1);
+        if( f+1 < framesNum )
+            reader = std::thread(&Animation::read_frame, this, f+1, &graphs[(f+1)%3], 1);
+        if( _frames[f].read )
+            bundle_frame(f, graph);
+        if( writer.joinable() )
+            writer.join();
+        if( reader.joinable() )
+            reader.join();
+    }
+    if( _frames[framesNum-1].read )
+        write_frame(framesNum-1, &graphs[(framesNum-1)%3], threadsNum);
+
+    int failedNum = 0;
+    for( int f=0; f<framesNum; f++ )
+        failedNum += _frames[f].ok ? 0 : 1;
+    _log.i("run", "%d frames are done in %.2lf s, %d failed",
+           framesNum, stopwatch.seconds(), failedNum);
+    return failedNum;
+}
+
+bool Animation::print_summary(std::string output_)
+{
+    meerkat::mk_table_writer table;
+    table.line("frame\tedges_file\tstatus\tedges\tcontinued\tread_s\tbundle_s\twrite_s");
+    for( size_t f=0; f<_frames.size(); f++ )
+    {
+        const Frame &frame = _frames[f];
+        table.line("%d\t%s\t%s\t%d\t%d\t%.3lf\t%.3lf\t%.3lf", (int)f,
+                   frame.job.edges.c_str(),
+                   !frame.read ? "read error" : (frame.ok ? "ok" : "write error"),
+                   frame.edgesNum, frame.continuedNum,
+                   frame.readTime, frame.bundleTime, frame.writeTime);
+    }
+    if( !table.write(output_) )
+    {
+        _log.e("print_summary", "could not write output file");
+        return false;
+    }
+    if( output_ != "" )
+        _log.i("print_summary", "summary is written in '%s'", output_.c_str());
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef ANIMATION_HPP
+#define ANIMATION_HPP
+
+#include <vector>
+#include <string>
+#include "meerkat_logger.hpp"
+#include "graph.hpp"
+#include "job.hpp"
+
+// Animation class
+// Bundles the frames of an evolving network: a sequence of edges files over the same
+// nodes file. Every frame continues from the bundled previous frame (see Graph::follow),
+// so that edges keep their shape between frames and only the last cycles of the
+// schedule are run. Continued edges whose compatible edges did not change are frozen, so
+// only the changed parts of the network are bundled again. Frames are processed as a pipeline: the next frame is read and the
+// previous one is written while the current one is bundled.
+//
+// Output names are the base output name with the frame index inserted before the
+// extension, e.g. out_0003.json.
+class Animation
+{
+private:
+    // Frame and its outcome
+    struct Frame
+    {
+        Job job;                        // Edges file and outputs of the frame.
+        bool read;                      // Marks whether the network is read.
+        bool ok;
+        int edgesNum;                   // Number of bundled edges.
+        int continuedNum;               // Number of edges continued from the previous frame.
+        double readTime;                // Time of reading (s).
+        double bundleTime;              // Time of compatibility lists and iterations (s).
+        double writeTime;               // Time of smoothing and writing outputs (s).
+    };
+
+    Job _base;
+    std::string _output;
+    std::vector<Frame> _frames;
+    meerkat::mk_log _log;
+
+    /**
+     * @brief read_frame Reads the network of a frame.
+     * @param frame_      Frame index.
+     * @param graph_      Graph of the frame.
+     * @param threadsNum_ Number of OpenMP threads.
+     */
+    void read_frame(int frame_, Graph *graph_, int threadsNum_);
+
+    /**
+     * @brief prepare_frame Continues a frame from the previous one if that is read, or
+     *                      else builds its compatibility lists.
+     * @param frame_    Frame index.
+     * @param graph_    Graph of the frame.
+     * @param previous_ Graph of the previous frame, NULL for the first frame.
+     */
+    void prepare_frame(int frame_, Graph *graph_, const Graph *previous_);
+
+    /**
+     * @brief bundle_frame Runs the iterations of a prepared frame.
+     * @param frame_ Frame index.
+     * @param graph_ Graph of the frame.
+     */
+    void bundle_frame(int frame_, Graph *graph_);
+
+    /**
+     * @brief write_frame Smooths a bundled frame and prints its outputs.
+     * @param frame_      Frame index.
+     * @param graph_      Graph of the frame.
+     * @param threadsNum_ Number of OpenMP threads.
+     */
+    void write_frame(int frame_, Graph *graph_, int threadsNum_);
+
+public:
+    /**
+     * @brief Animation Constructor.
+     * @param base_   Nodes file and parameters of all frames. The first frame starts
+     *                from base_.warmStart if it is set.
+     * @param output_ Base output name, the format is chosen by the extension.
+     */
+    Animation(const Job &base_, std::string output_);
+
+    /**
+     * @brief read_frames Reads the list of frames.
+     * @param list_ File with the edges file of one frame per line. Empty lines and lines
+     *              starting with '#' are skipped.
+     * @return      False if the file could not be read or lists no frames.
+     */
+    bool read_frames(std::string list_);
+
+    /**
+     * @brief run Bundles all frames.
+     * @return Number of failed frames.
+     */
+    int run();
+
+    /**
+     * @brief print_summary Prints the outcome and timings of the frames as tab separated
+     *                      values.
+     * @param output_ Name of output file, standard output if empty.
+     * @return        False if the file could not be written.
+     */
+    bool print_summary(std::string output_);
+};
+
+#endif // ANIMATION_HPP
@@ -0,0 +1,145 @@
+#include "batch.hpp"
+#include <fstream>
+#include <sstream>
+#include "worker_pool.hpp"
+#include "meerkat_stopwatch.hpp"
+#include "meerkat_table_writer.hpp"
+
+Batch::Batch(int workersNum_, double memoryLimit_)
+{
+    _log.tag("Batch");
+    _workersNum = workersNum_;
+    _memoryLimit = memoryLimit_ > 0.0 ? (size_t)(memoryLimit_ * 1048576.0) : 0;
+    _nextJob = 0;
+}
+
+bool Batch::read_manifest(std::string manifest_)
+{
+    std::ifstream f(manifest_.c_str());
+    if( !f )
+    {
+        _log.e("read_manifest", "could not read manifest file");
+        return false;
+    }
+    std::string line;
+    int lineIndex = 0;
+    while( std::getline(f, line) )
+    {
+        lineIndex++;
+        std::istringstream tokens(line);
+        std::string nodes, edges, output, invalid;
+        if( !(tokens >> nodes) || nodes[0] == '#' )
+            continue;
+        if( !(tokens >> edges >> output) )
+        {
+            _log.e("read_manifest", "line %d: expected nodes, edges and output", lineIndex);
+            return false;
+        }
+
+        Job job;
+        job.nodes = nodes;
+        job.edges = edges == "-" ? "" : edges;
+        job.set_output(output);
+        if( !job.set_params(tokens, invalid) )
+        {
+            _log.e("read_manifest", "line %d: invalid parameter '%s'",
+                   lineIndex, invalid.c_str());
+            return false;
+        }
+        _jobs.push_back(job);
+        _lines.push_back(lineIndex);
+    }
+    _log.i("read_manifest", "number of jobs: %i", (int)_jobs.size());
+    return true;
+}
+
+void Batch::execute(const Job &job_, Graph &graph_, Result &result_)
+{
+    result_.ok = false;
+    result_.edgesNum = 0;
+    result_.memory = 0.0;
+    result_.readTime = result_.bundleTime = result_.writeTime = 0.0;
+
+    meerkat::mk_stopwatch stopwatch;
+    job_.configure(graph_);
+    graph_.set_memory_limit(_memoryLimit);
+    bool read = job_.read(graph_);
+    result_.readTime = stopwatch.seconds();
+    if( !read )
+    {
+        // a refused network is kept until the next job to report its estimate
+        size_t memory = graph_.memory_estimate();
+        if( _memoryLimit > 0 && memory > _memoryLimit )
+        {
+            result_.status = "memory limit";
+            result_.memory = memory / 1048576.0;
+        }
+        else
+            result_.status = "read error";
+        return;
+    }
+    result_.memory = graph_.memory_estimate() / 1048576.0;
+    result_.edgesNum = (int)graph_.edges().size();
+
+    stopwatch.restart();
+    graph_.run();
+    result_.bundleTime = stopwatch.seconds();
+
+    stopwatch.restart();
+    result_.ok = job_.finish(graph_);
+    result_.writeTime = stopwatch.seconds();
+    result_.status = result_.ok ? "ok" : "write error";
+}
+
+void Batch::work(Graph &graph_)
+{
+    int jobsNum = (int)_jobs.size();
+    for( int j=_nextJob++; j<jobsNum; j=_nextJob++ )
+    {
+        execute(_jobs[j], graph_, _results[j]);
+        if( !_results[j].ok )
+            _log.w("work", "job of line %d failed: %s", _lines[j], _results[j].status);
+    }
+}
+
+int Batch::run()
+{
+    WorkerPool pool(_workersNum);
+    _log.i("run", "running %d jobs with %d workers of %d threads",
+           (int)_jobs.size(), pool.workers_num(), pool.threads_num());
+    _results.resize(_jobs.size());
+    _nextJob = 0;
+
+    meerkat::mk_stopwatch stopwatch;
+    pool.start([this](Graph &graph_) { work(graph_); });
+    pool.join();
+
+    int failedNum = 0;
+    for( size_t j=0; j<_results.size(); j++ )
+        failedNum += _results[j].ok ? 0 : 1;
+    _log.i("run", "%d of %d jobs are done in %.2lf s, %d failed",
+           (int)_jobs.size()-failedNum, (int)_jobs.size(), stopwatch.seconds(), failedNum);
+    return failedNum;
+}
+
+bool Batch::print_summary(std::string output_)
+{
+    meerkat::mk_table_writer table;
+    table.line("line\tnodes\tstatus\tedges\tmemory_mb\tread_s\tbundle_s\twrite_s\ttotal_s");
+    for( size_t j=0; j<_jobs.size(); j++ )
+    {
+        const Result &r = _results[j];
+        table.line("%d\t%s\t%s\t%d\t%.1lf\t%.3lf\t%.3lf\t%.3lf\t%.3lf",
+                   _lines[j], _jobs[j].nodes.c_str(), r.status, r.edgesNum, r.memory,
+                   r.readTime, r.bundleTime, r.writeTime,
+                   r.readTime + r.bundleTime + r.writeTime);
+    }
+    if( !table.write(output_) )
+    {
+        _log.e("print_summary", "could not write output file");
+        return false;
+    }
+    if( output_ != "" )
+        _log.i("print_summary", "summary is written in '%s'", output_.c_str());
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include "meerkat_logger.hpp"
+#include "graph.hpp"
+#include "job.hpp"
+
+// Batch class
+// Bundles the networks listed in a manifest on a fixed pool of workers. Each worker
+// keeps its own graph and bundles one network at a time with its share of the OpenMP
+// threads, so that many small networks keep all cores busy.
+//
+// Manifest lines are: nodes edges output [key=value ...], where '-' stands for the
+// edges file of binary graphs, output formats are chosen by extension (see
+// Job::set_output) and keys are long command line options without dashes.
+// Empty lines and lines starting with '#' are skipped.
+class Batch
+{
+private:
+    // Outcome of a job
+    struct Result
+    {
+        bool ok;
+        const char *status;             // Short description of the outcome.
+        int edgesNum;                   // Number of bundled edges.
+        double memory;                  // Estimated memory in MB.
+        double readTime;                // Time of reading and compatibility lists (s).
+        double bundleTime;              // Time of the iterations (s).
+        double writeTime;               // Time of smoothing and writing outputs (s).
+    };
+
+    std::vector<Job> _jobs;
+    std::vector<int> _lines;            // Manifest line of each job.
+    std::vector<Result> _results;
+    std::atomic<int> _nextJob;
+    int _workersNum;
+    size_t _memoryLimit;                // Memory limit of a job in bytes (0: unlimited).
+    meerkat::mk_log _log;
+
+    /**
+     * @brief work Runs jobs until all jobs are taken.
+     * @param graph_ Graph of the worker, reused by all jobs.
+     */
+    void work(Graph &graph_);
+
+    /**
+     * @brief execute Runs a single job.
+     * @param job_    Job.
+     * @param graph_  Graph of the worker.
+     * @param result_ Outcome of the job.
+     */
+    void execute(const Job &job_, Graph &graph_, Result &result_);
+
+public:
+    /**
+     * @brief Batch Constructor.
+     * @param workersNum_  Number of workers, 0 for one per core.
+     * @param memoryLimit_ Memory limit of a job in MB, 0 for no limit.
+     */
+    Batch(int workersNum_, double memoryLimit_);
+
+    /**
+     * @brief read_manifest Reads the jobs of a manifest.
+     * @param manifest_ Name of the manifest file.
+     * @return          False if the file could not be read or has an invalid line.
+     */
+    bool read_manifest(std::string manifest_);
+
+    /**
+     * @brief run Runs all jobs.
+     * OpenMP threads are divided among the workers.
+     * @return Number of failed jobs.
+     */
+    int run();
+
+    /**
+     * @brief print_summary Prints the outcome and timings of the jobs as tab separated
+     *                      values.
+     * @param output_ Name of output file, standard output if empty.
+     * @return        False if the file could not be written.
+     */
+    bool print_summary(std::string output_);
+};
+
+#endif // BATCH_HPP
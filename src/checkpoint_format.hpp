@@ -0,0 +1,36 @@
+#ifndef CHECKPOINT_FORMAT_HPP
+#define CHECKPOINT_FORMAT_HPP
+
+#include <stdint.h>
+
+// Checkpoint file layout (native byte order), written at the end of a cycle:
+//   CheckpointFileHeader
+//   uint64_t  pointOffsets[edgesNum+1]         subdivision points of edge i are
+//                                              points[pointOffsets[i]] ... points[pointOffsets[i+1]-1]
+//   double    points[2*pointsNum]              x0 y0 x1 y1 ...
+//   int32_t   compatibleOffsets[edgesNum+1]    see CompatibilityLists
+//   int32_t   compatibleEdges[compatibleNum]
+// The network itself is not stored, it is read again from the input files and
+// checked against networkHash.
+
+#define CHECKPOINT_FILE_MAGIC "FDEBCKPT"
+#define CHECKPOINT_FILE_VERSION 1
+
+// Header of the checkpoint file
+struct CheckpointFileHeader
+{
+    char magic[8];              // CHECKPOINT_FILE_MAGIC without terminating zero.
+    uint32_t version;           // CHECKPOINT_FILE_VERSION.
+    uint32_t byteOrder;         // GRAPH_FILE_BYTE_ORDER as written by the producer.
+    uint64_t networkHash;       // Hash of the edge end points.
+    uint64_t edgesNum;          // Number of edges.
+    uint64_t pointsNum;         // Total number of subdivision points.
+    uint64_t compatibleNum;     // Total length of the compatibility lists.
+    double S;                   // Displacement of the next cycle.
+    int32_t I;                  // Number of iterations of the next cycle.
+    int32_t iter;               // Remaining iterations of the next cycle.
+    int32_t cycles;             // Remaining cycles.
+    uint32_t reserved;          // Padding, zero.
+};
+
+#endif // CHECKPOINT_FORMAT_HPP
@@ -1,17 +1,17 @@
 #include "edge.hpp"
 
 
-Edge::Edge(std::string sourceLabel_, std::string targetLabel_,
+Edge::Edge(uint32_t source_, uint32_t target_,
            meerkat::mk_vector2 &start_, meerkat::mk_vector2 &end_,
            double width_)
 {
-    _sourceLabel = sourceLabel_;
-    _targetLabel = targetLabel_;
+    _source = source_;
+    _target = target_;
     _start = start_;
     _end = end_;
     _width = width_;
     arrange_direction();
-    add_subdivisions();
+    _subdivs.assign( 1, center(_start, _end) );
 }
 
 meerkat::mk_vector2 Edge::center(meerkat::mk_vector2 &p1_, meerkat::mk_vector2 &p2_)
@@ -39,7 +39,17 @@ meerkat::mk_vector2 Edge::vector()
     return _end-_start;
 }
 
-void Edge::add_subdivisions()
+double Edge::stroke_width() const
+{
+    return std::max(EDGE_MIN_STROKE, _width * EDGE_MAX_STROKE);
+}
+
+void Edge::reserve_subdivisions(int subdivsNum_)
+{
+    _subdivs.reserve(subdivsNum_);
+}
+
+void Edge::add_subdivisions(std::vector<meerkat::mk_vector2> &buffer_)
 {
     int oldSubdivsNum = (int)_subdivs.size();
     if( oldSubdivsNum == 0 )
@@ -48,12 +58,12 @@ void Edge::add_subdivisions()
     {
         int newSubdivsNum = 2 * oldSubdivsNum, subdivIndex = 0, v1Index = -1, v2Index = 0;
         double segmentLength = double(oldSubdivsNum+1)/double(newSubdivsNum+1);
-        std::vector<meerkat::mk_vector2> subdivisions(newSubdivsNum, meerkat::mk_vector2());
+        buffer_.resize(newSubdivsNum);
         meerkat::mk_vector2 v1 = _start, v2 = _subdivs[0];
         double r = segmentLength;
         while( subdivIndex < newSubdivsNum )
         {
-            subdivisions[subdivIndex] = v1 + (v2 - v1) * r;
+            buffer_[subdivIndex] = v1 + (v2 - v1) * r;
             subdivIndex++;
             if( r + segmentLength > 1.0 )
             {
@@ -71,7 +81,52 @@ void Edge::add_subdivisions()
             else
                 r += segmentLength;
         }
-        _subdivs = subdivisions;
+        _subdivs.swap(buffer_);
+    }
+}
+
+void Edge::resample(const meerkat::mk_vector2 *polyline_, int pointsNum_, int subdivsNum_)
+{
+    // orientation and end point displacements
+    const meerkat::mk_vector2 &first = polyline_[0], &last = polyline_[pointsNum_-1];
+    bool reversed = (first-_end).length() + (last-_start).length()
+            < (first-_start).length() + (last-_end).length();
+    meerkat::mk_vector2 startShift = (reversed ? _start-last : _start-first);
+    meerkat::mk_vector2 endShift = (reversed ? _end-first : _end-last);
+
+    // arc length
+    double total = 0.0;
+    for( int k=1; k<pointsNum_; k++ )
+        total += (polyline_[k]-polyline_[k-1]).length();
+
+    _subdivs.resize(subdivsNum_);
+    int segment = 0;
+    double covered = 0.0;
+    for( int i=0; i<subdivsNum_; i++ )
+    {
+        double t = double(i+1) / double(subdivsNum_+1);
+        if( total < EPSILON )
+        {
+            _subdivs[i] = _start + (_end-_start) * t;
+            continue;
+        }
+        // segments are walked once, in the direction of the edge
+        double s = t * total, length = 0.0;
+        meerkat::mk_vector2 a, b;
+        while( true )
+        {
+            int ia = reversed ? pointsNum_-1-segment : segment;
+            int ib = reversed ? ia-1 : ia+1;
+            a = polyline_[ia];
+            b = polyline_[ib];
+            length = (b-a).length();
+            if( covered + length >= s || segment == pointsNum_-2 )
+                break;
+            covered += length;
+            segment++;
+        }
+        meerkat::mk_vector2 point = length > EPSILON ? a + (b-a) * std::min(1.0, (s-covered)/length) : a;
+        _subdivs[i] = point + startShift * (1.0-t) + endShift * t;
     }
 }
 
@@ -127,14 +182,64 @@ void Edge::add_gravitational_forces(std::vector<meerkat::mk_vector2> &forces_,
                                     double exponent_)
 {
     int len = (int)_subdivs.size();
-    meerkat::mk_vector2 dist;
-    double dlen;
+    double dx[GRAVITATION_BLOCK], dy[GRAVITATION_BLOCK], base[GRAVITATION_BLOCK], power[GRAVITATION_BLOCK];
 
-    for( int i=0; i<len; i++ )
+    // check if exponent is an integer or half-integer, larger exponents are not converted
+    int twiceExponent = 0;
+    bool isHalfInteger = false;
+    if( fabs(exponent_) <= GRAVITATION_MAX_EXPONENT )
     {
-        dist = (center_ - _subdivs[i]);
-        dlen = dist.length();
-        forces_[i] += dist * 0.1 * pow(dlen+1.0, exponent_);
+        twiceExponent = (int)floor(2.0*exponent_ + 0.5);
+        isHalfInteger = fabs(2.0*exponent_ - twiceExponent) < EPSILON;
+    }
+    int multiplications = abs(twiceExponent) / 2;
+
+    for( int b=0; b<len; b+=GRAVITATION_BLOCK )
+    {
+        int blockLen = std::min(GRAVITATION_BLOCK, len-b);
+        for( int k=0; k<blockLen; k++ )
+        {
+            dx[k] = center_.x() - _subdivs[b+k].x();
+            dy[k] = center_.y() - _subdivs[b+k].y();
+            base[k] = sqrt(dx[k]*dx[k] + dy[k]*dy[k]) + 1.0;
+        }
+
+        if( isHalfInteger )
+        {
+            // odd multiples of 1/2 start from the square root
+            if( twiceExponent % 2 != 0 )
+            {
+                #pragma omp simd
+                for( int k=0; k<blockLen; k++ )
+                    power[k] = sqrt(base[k]);
+            }
+            else
+            {
+                for( int k=0; k<blockLen; k++ )
+                    power[k] = 1.0;
+            }
+            for( int m=0; m<multiplications; m++ )
+            {
+                #pragma omp simd
+                for( int k=0; k<blockLen; k++ )
+                    power[k] *= base[k];
+            }
+            if( twiceExponent < 0 )
+            {
+                #pragma omp simd
+                for( int k=0; k<blockLen; k++ )
+                    power[k] = 1.0 / power[k];
+            }
+        }
+        else
+        {
+            // no vector exp/log without -ffast-math, this loop stays scalar
+            for( int k=0; k<blockLen; k++ )
+                power[k] = exp(exponent_ * log(base[k]));
+        }
+
+        for( int k=0; k<blockLen; k++ )
+            forces_[b+k] += meerkat::mk_vector2(dx[k], dy[k]) * (0.1 * power[k]);
     }
 }
 
@@ -150,59 +255,100 @@ void Edge::update(std::vector<meerkat::mk_vector2> &forces_, double S_)
     }
 }
 
-void Edge::smooth(double sigma_)
+void Edge::smooth(std::vector<double> &kernel_, std::vector<double> &norms_,
+                  std::vector<meerkat::mk_vector2> &buffer_)
 {
-    int len = (int)_subdivs.size();
-    std::vector<meerkat::mk_vector2> subdivisions(len, meerkat::mk_vector2(0.0, 0.0));
-    double weight, total_weight;
+    int len = (int)_subdivs.size(), radius = (int)kernel_.size()-1;
+    std::vector<meerkat::mk_vector2> &subdivisions = buffer_;
+    subdivisions.assign(len, meerkat::mk_vector2(0.0, 0.0));
     for( int i=0; i<len; i++ )
     {
-        total_weight = 0.0;
-
         // start point
-        weight = gauss_weight(i+1, sigma_);
-        subdivisions[i] += _start * weight;
-        total_weight += weight;
-        // inner points
-        for( int j=0; j<len; j++ )
-        {
-            weight = gauss_weight(i-j, sigma_);
-            subdivisions[i] += _subdivs[j] * weight;
-            total_weight += weight;
-        }
+        if( i+1 <= radius )
+            subdivisions[i] += _start * kernel_[i+1];
+        // inner points within the kernel window
+        int jMin = std::max(0, i-radius), jMax = std::min(len-1, i+radius);
+        for( int j=jMin; j<=jMax; j++ )
+            subdivisions[i] += _subdivs[j] * kernel_[abs(i-j)];
         // end point
-        weight = gauss_weight(len-i+1, sigma_);
-        subdivisions[i] += _end * weight;
-        total_weight += weight;
+        if( len-i+1 <= radius )
+            subdivisions[i] += _end * kernel_[len-i+1];
 
         // normalize
-        subdivisions[i] /= total_weight;
+        subdivisions[i] *= norms_[i];
     }
 
     // replace division points
-    _subdivs = subdivisions;
+    _subdivs.swap(subdivisions);
 }
 
-void Edge::draw(double alpha_)
+/**
+ * @brief segment_distance Calculates the distance of a point from a segment.
+ * @param point_ Point.
+ * @param a_     First end of the segment.
+ * @param b_     Second end of the segment.
+ * @return       Distance.
+ */
+static double segment_distance(const meerkat::mk_vector2 &point_,
+                               const meerkat::mk_vector2 &a_,
+                               const meerkat::mk_vector2 &b_)
 {
-    glLineWidth( _width );
-    glColor4f( 212./255., 0./255., 0./255., alpha_ );
+    meerkat::mk_vector2 ab = b_ - a_, ap = point_ - a_;
+    double l2 = ab * ab;
+    if( l2 < EPSILON*EPSILON )
+        return ap.length();
+    double t = std::min(1.0, std::max(0.0, (ap * ab) / l2));
+    return (ap - ab * t).length();
+}
+
+void Edge::simplify(double tolerance_, std::vector<char> &keep_, std::vector<int> &stack_)
+{
+    // polyline points are indexed as start (0), subdivisions (1..len) and end (len+1)
     int len = (int)_subdivs.size();
+    keep_.assign(len+2, 0);
+    keep_[0] = keep_[len+1] = 1;
+    stack_.clear();
+    stack_.push_back(0);
+    stack_.push_back(len+1);
+    while( !stack_.empty() )
+    {
+        int last = stack_.back();
+        stack_.pop_back();
+        int first = stack_.back();
+        stack_.pop_back();
+        const meerkat::mk_vector2 &a = first == 0 ? _start : _subdivs[first-1];
+        const meerkat::mk_vector2 &b = last == len+1 ? _end : _subdivs[last-1];
 
-    glBegin( GL_LINES );
-    // first segment
-    glVertex2d( _start.x(), _start.y() );
-    glVertex2d( _subdivs[0].x(), _subdivs[0].y() );
-    // inner segments
-    for( int i=0; i<len-1; i++ )
+        // farthest point from the segment
+        double maxDistance = -1.0;
+        int farthest = -1;
+        for( int k=first+1; k<last; k++ )
+        {
+            double d = segment_distance(_subdivs[k-1], a, b);
+            if( d > maxDistance )
+            {
+                maxDistance = d;
+                farthest = k;
+            }
+        }
+        if( farthest > 0 && maxDistance > tolerance_ )
+        {
+            keep_[farthest] = 1;
+            stack_.push_back(first);
+            stack_.push_back(farthest);
+            stack_.push_back(farthest);
+            stack_.push_back(last);
+        }
+    }
+
+    // compact kept subdivisions
+    int kept = 0;
+    for( int k=1; k<=len; k++ )
     {
-        glVertex2d( _subdivs[i].x(), _subdivs[i].y() );
-        glVertex2d( _subdivs[i+1].x(), _subdivs[i+1].y() );
+        if( keep_[k] )
+            _subdivs[kept++] = _subdivs[k-1];
     }
-    // last segment
-    glVertex2d( _subdivs[len-1].x(), _subdivs[len-1].y() );
-    glVertex2d( _end.x(), _end.y() );
-    glEnd();
+    _subdivs.resize(kept);
 }
 
 double Edge::edge_visibility(Edge &edge1_, Edge &edge2_)
@@ -252,14 +398,3 @@ double Edge::visibility_compability(Edge &edge1_, Edge &edge2_)
     return std::min(edge_visibility(edge1_, edge2_),
                     edge_visibility(edge2_, edge1_));
 }
-
-int compare_edges( Edge edge1_,  Edge edge2_ )
-{
-    if( edge1_._width < edge2_._width )
-        return 1;
-    else if( edge1_._width > edge2_._width )
-        return -1;
-    else
-        return 0;
-}
-
@@ -3,13 +3,17 @@
 
 #include <vector>
 #include <string>
+#include <stdint.h>
 #include "meerkat_vector2.hpp"
-#include "GLUT/glut.h"
 #include"math.h"
 #include <algorithm>
 
 #define EPSILON 1e-6
 #define INV_SQRT_2PI 0.3989422804
+#define GRAVITATION_BLOCK 64            // Points processed together in the gravitation kernel.
+#define GRAVITATION_MAX_EXPONENT 8      // Largest exponent evaluated by multiplications.
+#define EDGE_MAX_STROKE 2.0             // Stroke width of the heaviest edges in pixels.
+#define EDGE_MIN_STROKE 0.2             // Smallest stroke width in pixels.
 
 
 double gauss_weight(int dist_, double sigma_);
@@ -18,31 +22,57 @@ double gauss_weight(int dist_, double sigma_);
 struct Edge
 {
     // Variables
-    std::string _sourceLabel;                       // Label of source node.
-    std::string _targetLabel;                       // Label of target node.
+    uint32_t _source;                               // Index of source node.
+    uint32_t _target;                               // Index of target node.
     meerkat::mk_vector2 _start;                     // Start point.
     meerkat::mk_vector2 _end;                       // End point.
     std::vector<meerkat::mk_vector2> _subdivs;      // Subdivision points.
-    double _width;                                  // Width.
-    std::vector<int> _compatibleEdges;              // List of compatible edge indices.
+    double _width;                                  // Width, weight normalized into (0, 1].
 
     /**
      * @brief Edge Constructor.
      * Sets end points, arranges direction and adds first subdivision point.
-     * @param sourceLabel_ Source node label.
-     * @param targetLabel_ Target node label.
-     * @param start_       Start coordinates.
-     * @param end_         End coordinates.
-     * @param width_       Edge width.
+     * @param source_ Source node index.
+     * @param target_ Target node index.
+     * @param start_  Start coordinates.
+     * @param end_    End coordinates.
+     * @param width_  Edge width.
      */
-    Edge(std::string sourceLabel_, std::string targetLabel_,
+    Edge(uint32_t source_, uint32_t target_,
          meerkat::mk_vector2 &start_, meerkat::mk_vector2 &end_,
          double width_);
 
     /**
-     * @brief add_subdivisions Adds subdivision points.
+     * @brief stroke_width Returns the stroke width of the edge in rendered images:
+     *                     proportional to the width, EDGE_MAX_STROKE for the heaviest
+     *                     edges and at least EDGE_MIN_STROKE.
+     * @return Stroke width in pixels.
      */
-    void add_subdivisions();
+    double stroke_width() const;
+
+    /**
+     * @brief reserve_subdivisions Reserves storage for subdivision points.
+     * @param subdivsNum_ Final number of subdivision points.
+     */
+    void reserve_subdivisions(int subdivsNum_);
+
+    /**
+     * @brief add_subdivisions Doubles the number of subdivision points.
+     * @param buffer_ Scratch buffer with the same reserved capacity as the
+     *                subdivisions, it is swapped with the old points.
+     */
+    void add_subdivisions(std::vector<meerkat::mk_vector2> &buffer_);
+
+    /**
+     * @brief resample Places the subdivision points at equal arc length along a
+     *                 polyline of the same edge, e.g., from an earlier result. The polyline
+     *                 is reversed if its first point is closer to the end point, and is
+     *                 bent to follow end points that have moved since.
+     * @param polyline_    Points of the polyline including its end points.
+     * @param pointsNum_   Number of points of the polyline, at least 2.
+     * @param subdivsNum_  Number of subdivision points.
+     */
+    void resample(const meerkat::mk_vector2 *polyline_, int pointsNum_, int subdivsNum_);
 
     /**
      * @brief arrange_direction Arranges edge direction to standardize order of
@@ -58,11 +88,23 @@ struct Edge
     void update(std::vector<meerkat::mk_vector2> &forces_, double S_);
 
     /**
-     * @brief smooth Smoothes edge.
-     * @param sigma_ Width of kernel.
+     * @brief smooth Smoothes edge by a truncated Gaussian convolution.
+     * @param kernel_ Kernel weights indexed by distance, the last entry being
+     *                the truncation radius.
+     * @param norms_  Inverse of the total weight for each subdivision point.
+     * @param buffer_ Scratch buffer receiving the smoothed points, swapped with
+     *                the subdivisions afterwards.
      */
-    void smooth(double sigma_);
+    void smooth(std::vector<double> &kernel_, std::vector<double> &norms_,
+                std::vector<meerkat::mk_vector2> &buffer_);
 
+    /**
+     * @brief simplify Removes subdivision points with the Douglas-Peucker algorithm.
+     * @param tolerance_ Maximum distance of removed points from the simplified polyline.
+     * @param keep_      Scratch buffer for the kept point flags.
+     * @param stack_     Scratch buffer for the segments to process.
+     */
+    void simplify(double tolerance_, std::vector<char> &keep_, std::vector<int> &stack_);
 
     /**
      * @brief add_spring_forces Increments total forces by the spring forces.
@@ -90,6 +132,9 @@ struct Edge
      * F_grav = pow( |s - center|, beta )
      * where s and center are the position of the subdivision point and the graviational center,
      * respectively.
+     * Integer and half-integer exponents up to GRAVITATION_MAX_EXPONENT are evaluated by
+     * repeated multiplication (and a square root), which are vectorized over blocks of
+     * points. Other exponents go through exp/log point by point.
      */
     void add_gravitational_forces(std::vector<meerkat::mk_vector2> &forces_,
                                   meerkat::mk_vector2 &center_,
@@ -101,12 +146,6 @@ struct Edge
      */
     meerkat::mk_vector2 vector();
 
-    /**
-     * @brief draw Draws the edge.
-     * @param alpha_ Opacity of edge.
-     */
-    void draw(double alpha_);
-
     /**
      * @brief center Calculates the center of two vectors.
      * @param p1_ First vector.
@@ -167,6 +206,4 @@ struct Edge
     static double visibility_compability(Edge &edge1_, Edge &edge2_);
 };
 
-int compare_edges( Edge edge1_, Edge edge2_ );
-
 #endif // EDGE_HPP
@@ -0,0 +1,86 @@
+#include "fdeb.h"
+#include <new>
+#include "graph.hpp"
+
+static_assert(sizeof(meerkat::mk_vector2) == 2*sizeof(double),
+              "polylines are handed out as arrays of coordinates");
+
+// A handle is a graph that is reused between runs.
+struct fdeb_graph
+{
+    Graph graph;
+};
+
+void fdeb_default_params(fdeb_params *params)
+{
+    params->K = 0.1;
+    params->cycles = 5;
+    params->I = 90;
+    params->compat = 0.6;
+    params->sigma = 3.0;
+    params->S = 0.4;
+    params->epsilon = 1e-4;
+    params->gravitation = 0;
+    params->gravitation_center[0] = 0.0;
+    params->gravitation_center[1] = 0.0;
+    params->gravitation_exponent = 1.0;
+    params->edge_weight = -1.0;
+    params->edge_percentage = -1.0;
+    params->merge_edges = 0;
+    params->verbose = 0;
+}
+
+fdeb_graph *fdeb_create(void)
+{
+    return new (std::nothrow) fdeb_graph;
+}
+
+void fdeb_destroy(fdeb_graph *graph)
+{
+    delete graph;
+}
+
+int fdeb_bundle(fdeb_graph *graph, const fdeb_params *params,
+                const double *coords, uint32_t nodes_num,
+                const uint32_t *edges, const double *weights, uint32_t edges_num)
+{
+    if( params->cycles < 0 || params->cycles > MAX_CYCLES || params->I < 0 )
+        return -1;
+
+    // all parameters are set again, they are changed by a run
+    Graph &g = graph->graph;
+    g.set_severity_level(params->verbose ? meerkat::mk_log::SLInfo : meerkat::mk_log::SLError);
+    g.set_algorithm_params(params->K, params->cycles, params->I, params->compat, params->sigma);
+    g.set_network_params(params->edge_weight, params->edge_percentage, params->merge_edges != 0);
+    g.set_physics_params(params->S, params->epsilon,
+                         meerkat::mk_vector2(params->gravitation_center[0],
+                                             params->gravitation_center[1]),
+                         params->gravitation_exponent);
+    g.enable_gravitation(params->gravitation != 0);
+
+    if( !g.load(coords, nodes_num, edges, weights, edges_num, true) )
+        return -1;
+    g.run();
+    g.smooth();
+    return (int)g.edges().size();
+}
+
+int fdeb_edges_num(const fdeb_graph *graph)
+{
+    return (int)graph->graph.edges().size();
+}
+
+int fdeb_get_polyline(const fdeb_graph *graph, int edge, fdeb_polyline *polyline)
+{
+    const std::vector<Edge> &edges = graph->graph.edges();
+    if( edge < 0 || edge >= (int)edges.size() )
+        return -1;
+    const Edge &e = edges[edge];
+    polyline->source = e._source;
+    polyline->target = e._target;
+    polyline->start = reinterpret_cast<const double *>(&e._start);
+    polyline->end = reinterpret_cast<const double *>(&e._end);
+    polyline->points = reinterpret_cast<const double *>(e._subdivs.data());
+    polyline->points_num = (int)e._subdivs.size();
+    return 0;
+}
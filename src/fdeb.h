@@ -0,0 +1,84 @@
+/*
+ * C interface of the edge bundling engine.
+ *
+ * A handle holds a network and all buffers of the algorithm, and is meant to be
+ * reused: storage allocated by a call is kept for the next one. Input arrays are
+ * owned by the caller and are only read during fdeb_bundle. Polylines point into
+ * the storage of the handle, they are valid until the next fdeb_bundle or
+ * fdeb_destroy call on the same handle. A handle must not be used from multiple
+ * threads at the same time, separate handles are independent.
+ */
+
+#ifndef FDEB_H
+#define FDEB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fdeb_graph fdeb_graph;
+
+/* Parameters of a run, the command line options of fdeb with the same defaults. */
+typedef struct fdeb_params
+{
+    double K;                           /* Edge stiffness. */
+    int cycles;                         /* Number of cycles. */
+    int I;                              /* Initial number of iterations. */
+    double compat;                      /* Compatibility threshold. */
+    double sigma;                       /* Smoothing width. */
+    double S;                           /* Initial displacement. */
+    double epsilon;                     /* Lowest interaction distance. */
+    int gravitation;                    /* Non-zero to turn gravitation on. */
+    double gravitation_center[2];       /* Gravitation center. */
+    double gravitation_exponent;        /* Gravitation exponent. */
+    double edge_weight;                 /* Edge weight threshold, unset if not positive. */
+    double edge_percentage;             /* Percentage of strongest edges kept, unset if not positive. */
+    int merge_edges;                    /* Non-zero to merge parallel and anti-parallel edges. */
+    int verbose;                        /* Non-zero to log progress, errors are always logged. */
+} fdeb_params;
+
+/* An edge of the bundled network, pointing into the storage of the handle. */
+typedef struct fdeb_polyline
+{
+    uint32_t source;                    /* Index of the source node. */
+    uint32_t target;                    /* Index of the target node. */
+    const double *start;                /* First point (x, y), one of the end nodes. */
+    const double *end;                  /* Last point (x, y), the other end node. */
+    const double *points;               /* Subdivision points between them (x0, y0, x1, y1, ...). */
+    int points_num;                     /* Number of subdivision points. */
+} fdeb_polyline;
+
+/* Fills the parameters with the default values. */
+void fdeb_default_params(fdeb_params *params);
+
+/* Creates a handle, NULL if out of memory. */
+fdeb_graph *fdeb_create(void);
+
+/* Destroys a handle and its storage. */
+void fdeb_destroy(fdeb_graph *graph);
+
+/*
+ * Bundles a network: coords holds the node coordinates (x0, y0, x1, y1, ...), edges
+ * the node indices of the edges (source0, target0, ...) and weights the edge weights
+ * or NULL, in which case every edge has weight 1 as in edges files without weights.
+ * Runs all cycles and smoothes the edges.
+ * Returns the number of bundled edges, or -1 if cycles is not between 0 and 24, I is
+ * negative, an edge refers to an unknown node or no edge is kept by the filters.
+ */
+int fdeb_bundle(fdeb_graph *graph, const fdeb_params *params,
+                const double *coords, uint32_t nodes_num,
+                const uint32_t *edges, const double *weights, uint32_t edges_num);
+
+/* Returns the number of bundled edges of the last run. */
+int fdeb_edges_num(const fdeb_graph *graph);
+
+/* Gets a bundled edge of the last run. Returns 0 on success, -1 if the index is invalid. */
+int fdeb_get_polyline(const fdeb_graph *graph, int edge, fdeb_polyline *polyline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FDEB_H */
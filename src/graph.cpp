@@ -1,4 +1,32 @@
 #include "graph.hpp"
+#include <sys/stat.h>
+#include <errno.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int thread_count()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static bool make_directory(const std::string &path_)
+{
+    return mkdir(path_.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+static int thread_index()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
 
 Graph::Graph()
 {
@@ -19,159 +47,1324 @@ Graph::Graph()
 
     _edgeWeightThreshold = -1.0;
     _edgePercentageThreshold = -1.0;
+    _mergeEdges = false;
+    _memoryLimit = 0;
+
+    _timeBudget = 0.0;
+    _stopFlag = NULL;
 
     _edgeOpacity = 0.1;
+
+    _compactJson = false;
+    _precision = 6;
+
+    _integerLabels = false;
+}
+
+void Graph::set_network_params(double edgeWeightThreshold_, double edgePercentageThreshold_,
+                               bool mergeEdges_)
+{
+    _mergeEdges = mergeEdges_;
+    // weight threshold takes precedence
+    _edgeWeightThreshold = edgeWeightThreshold_;
+    _edgePercentageThreshold = edgeWeightThreshold_ > 0.0 ? -1.0 : edgePercentageThreshold_;
+}
+
+void Graph::set_algorithm_params(double K_, int cycles_, int I0_, double compat_, double sigma_)
+{
+    _K = K_;
+    _cycles = cycles_;
+    _I = I0_;
+    _iter = _I;
+    _compatibilityThreshold = compat_;
+    _smoothWidth = sigma_;
+}
+
+void Graph::set_physics_params(double S0_, double edgeDistance_,
+                               meerkat::mk_vector2 gravCenter_,
+                               double gravExponent_)
+{
+    _S = S0_;
+    _edgeDistance = edgeDistance_;
+    _gravitationCenter = gravCenter_;
+    _gravitationExponent = gravExponent_;
 }
 
-void Graph::set_network_params(double edgeWeightThreshold_, double edgePercentageThreshold_)
+void Graph::enable_gravitation(bool enabled_)
 {
-    if( edgeWeightThreshold_ > 0.0 )
-        _edgeWeightThreshold = edgeWeightThreshold_;
-    else if( edgePercentageThreshold_ > 0.0 )
-        _edgePercentageThreshold = edgePercentageThreshold_;
+    if( enabled_ )
+        _log.i("enable_gravitation", "gravitation is enabled");
+    _gravitationIsOn = enabled_;
 }
 
-void Graph::set_algorithm_params(double K_, int cycles_, int I0_, double compat_, double sigma_)
-{
-    _K = K_;
-    _cycles = cycles_;
-    _I = I0_;
-    _iter = _I;
-    _compatibilityThreshold = compat_;
-    _smoothWidth = sigma_;
+void Graph::set_checkpoint(std::string file_)
+{
+    _checkpointFile = file_;
+}
+
+uint64_t Graph::network_hash() const
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for( size_t i=0; i<_edges.size(); i++ )
+    {
+        uint32_t ends[2] = {_edges[i]._source, _edges[i]._target};
+        const unsigned char *p = (const unsigned char *)ends;
+        for( size_t b=0; b<sizeof(ends); b++ )
+        {
+            hash ^= p[b];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+void Graph::checkpoint()
+{
+    // the state is copied into the buffer, the iterations continue while it is written
+    std::vector<char> &buffer = _checkpointWriter.buffer();
+    if( !_checkpointWriter.wait() )
+        _log.w("checkpoint", "could not write checkpoint file");
+    uint64_t edgesNum = _edges.size(), pointsNum = 0;
+    for( uint64_t i=0; i<edgesNum; i++ )
+        pointsNum += _edges[i]._subdivs.size();
+    uint64_t compatibleNum = _compatibility ? _compatibility->edges.size() : 0;
+
+    CheckpointFileHeader header;
+    memset(&header, 0, sizeof(CheckpointFileHeader));
+    memcpy(header.magic, CHECKPOINT_FILE_MAGIC, 8);
+    header.version = CHECKPOINT_FILE_VERSION;
+    header.byteOrder = GRAPH_FILE_BYTE_ORDER;
+    header.networkHash = network_hash();
+    header.edgesNum = edgesNum;
+    header.pointsNum = pointsNum;
+    header.compatibleNum = compatibleNum;
+    header.S = _S;
+    header.I = _I;
+    header.iter = _iter;
+    header.cycles = _cycles;
+
+    buffer.resize(sizeof(CheckpointFileHeader) + (edgesNum+1)*sizeof(uint64_t)
+                  + 2*pointsNum*sizeof(double) + (edgesNum+1+compatibleNum)*sizeof(int32_t));
+    char *p = buffer.data();
+    memcpy(p, &header, sizeof(CheckpointFileHeader));
+    uint64_t *pointOffsets = (uint64_t *)(p + sizeof(CheckpointFileHeader));
+    double *points = (double *)(pointOffsets + edgesNum + 1);
+    pointOffsets[0] = 0;
+    for( uint64_t i=0; i<edgesNum; i++ )
+    {
+        const std::vector<meerkat::mk_vector2> &subdivs = _edges[i]._subdivs;
+        pointOffsets[i+1] = pointOffsets[i] + subdivs.size();
+        for( size_t k=0; k<subdivs.size(); k++ )
+        {
+            points[2*(pointOffsets[i]+k)] = subdivs[k].x();
+            points[2*(pointOffsets[i]+k)+1] = subdivs[k].y();
+        }
+    }
+    int32_t *compatibleOffsets = (int32_t *)(points + 2*pointsNum);
+    if( _compatibility )
+    {
+        memcpy(compatibleOffsets, _compatibility->offsets.data(), (edgesNum+1)*sizeof(int32_t));
+        memcpy(compatibleOffsets + edgesNum + 1, _compatibility->edges.data(),
+               compatibleNum*sizeof(int32_t));
+    }
+    else
+        memset(compatibleOffsets, 0, (edgesNum+1)*sizeof(int32_t));
+    _checkpointWriter.write(_checkpointFile);
+    _log.i("checkpoint", "writing checkpoint with %d cycles left", _cycles);
+}
+
+bool Graph::resume(std::string file_)
+{
+    meerkat::mk_mapped_file file;
+    CheckpointFileHeader header;
+    if( !file.open(file_) || file.size() < sizeof(CheckpointFileHeader) )
+    {
+        _log.e("resume", "could not read checkpoint file");
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(CheckpointFileHeader));
+    uint64_t edgesNum = header.edgesNum, pointsNum = header.pointsNum;
+    if( edgesNum > file.size() || pointsNum > file.size() || header.compatibleNum > file.size() )
+    {
+        _log.e("resume", "invalid checkpoint file");
+        return false;
+    }
+    uint64_t totalSize = sizeof(CheckpointFileHeader) + (edgesNum+1)*sizeof(uint64_t)
+            + 2*pointsNum*sizeof(double) + (edgesNum+1+header.compatibleNum)*sizeof(int32_t);
+    if( memcmp(header.magic, CHECKPOINT_FILE_MAGIC, 8) != 0
+            || header.version != CHECKPOINT_FILE_VERSION
+            || header.byteOrder != GRAPH_FILE_BYTE_ORDER
+            || totalSize != file.size() )
+    {
+        _log.e("resume", "invalid checkpoint file");
+        return false;
+    }
+    if( edgesNum != _edges.size() || header.networkHash != network_hash() )
+    {
+        _log.e("resume", "checkpoint belongs to another network");
+        return false;
+    }
+
+    // lists are checked before they are used by the iterations
+    const uint64_t *pointOffsets = (const uint64_t *)(file.data() + sizeof(CheckpointFileHeader));
+    const double *points = (const double *)(pointOffsets + edgesNum + 1);
+    const int32_t *compatibleOffsets = (const int32_t *)(points + 2*pointsNum);
+    std::shared_ptr<CompatibilityLists> lists(new CompatibilityLists);
+    lists->offsets.assign(compatibleOffsets, compatibleOffsets + edgesNum + 1);
+    lists->edges.assign(compatibleOffsets + edgesNum + 1,
+                        compatibleOffsets + edgesNum + 1 + header.compatibleNum);
+    // every edge has the same number of subdivisions, which is doubled in each remaining
+    // cycle up to the number of a full run
+    uint64_t subdivsNum = edgesNum > 0 ? pointOffsets[1] - pointOffsets[0] : 0;
+    bool valid = pointOffsets[0] == 0 && pointOffsets[edgesNum] == pointsNum
+            && lists->offsets[0] == 0 && (uint64_t)lists->offsets[edgesNum] == header.compatibleNum
+            && header.cycles > 0 && header.cycles <= MAX_CYCLES
+            && header.I >= 0 && header.iter >= 0 && header.iter <= header.I
+            && (edgesNum == 0 || (subdivsNum > 0 && subdivsNum << header.cycles <= (1ull << MAX_CYCLES)));
+    for( uint64_t i=0; i<edgesNum && valid; i++ )
+        valid = pointOffsets[i+1] - pointOffsets[i] == subdivsNum
+                && lists->offsets[i] <= lists->offsets[i+1];
+    for( uint64_t j=0; j<header.compatibleNum && valid; j++ )
+        valid = lists->edges[j] >= 0 && (uint64_t)lists->edges[j] < edgesNum;
+    if( !valid )
+    {
+        _log.e("resume", "invalid checkpoint file");
+        return false;
+    }
+
+    _S = header.S;
+    _I = header.I;
+    _iter = header.iter;
+    _cycles = header.cycles;
+    _compatibility = lists;
+
+    // subdivisions are doubled at the end of each remaining cycle
+    size_t maxSubdivsNum = 0;
+    for( uint64_t i=0; i<edgesNum; i++ )
+    {
+        std::vector<meerkat::mk_vector2> &subdivs = _edges[i]._subdivs;
+        size_t subdivsNum = pointOffsets[i+1] - pointOffsets[i];
+        subdivs.reserve(subdivsNum << _cycles);
+        subdivs.resize(subdivsNum);
+        for( size_t k=0; k<subdivsNum; k++ )
+            subdivs[k].set(points[2*(pointOffsets[i]+k)], points[2*(pointOffsets[i]+k)+1]);
+        maxSubdivsNum = std::max(maxSubdivsNum, subdivsNum << _cycles);
+    }
+    for( int t=0; t<(int)_subdivBuffers.size(); t++ )
+        _subdivBuffers[t].reserve(maxSubdivsNum);
+    _log.i("resume", "resuming with %d cycles left", _cycles);
+    return true;
+}
+
+// Position in a JSON text
+struct JsonCursor
+{
+    const char *p;
+    const char *end;
+
+    void skip_whitespace()
+    {
+        while( p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') )
+            p++;
+    }
+
+    bool accept(char c_)
+    {
+        skip_whitespace();
+        if( p < end && *p == c_ )
+        {
+            p++;
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief read_json_string Reads a JSON string, escapes of characters above 0x7f are
+ *                         not supported.
+ * @param cursor_ Position, moved past the string.
+ * @param value_  Unescaped string.
+ * @return        False if there is no valid string at the position.
+ */
+static bool read_json_string(JsonCursor &cursor_, std::string &value_)
+{
+    if( !cursor_.accept('"') )
+        return false;
+    value_.clear();
+    while( cursor_.p < cursor_.end && *cursor_.p != '"' )
+    {
+        char c = *cursor_.p++;
+        if( c == '\\' )
+        {
+            if( cursor_.p >= cursor_.end )
+                return false;
+            c = *cursor_.p++;
+            if( c == 'u' )
+            {
+                unsigned int code = 0;
+                if( cursor_.end - cursor_.p < 4 || sscanf(cursor_.p, "%4x", &code) != 1 || code > 0x7f )
+                    return false;
+                cursor_.p += 4;
+                c = (char)code;
+            }
+            else if( c == 'n' )
+                c = '\n';
+            else if( c == 't' )
+                c = '\t';
+            else if( c == 'r' )
+                c = '\r';
+            else if( c == 'b' )
+                c = '\b';
+            else if( c == 'f' )
+                c = '\f';
+        }
+        value_ += c;
+    }
+    return cursor_.accept('"');
+}
+
+/**
+ * @brief read_json_number Reads a JSON number.
+ * @param cursor_ Position, moved past the number.
+ * @param value_  Number.
+ * @return        False if there is no number at the position.
+ */
+static bool read_json_number(JsonCursor &cursor_, double &value_)
+{
+    cursor_.skip_whitespace();
+    char text[64];
+    size_t length = 0;
+    while( cursor_.p + length < cursor_.end && length < sizeof(text)-1
+           && strchr("+-.0123456789eE", cursor_.p[length]) != NULL )
+    {
+        text[length] = cursor_.p[length];
+        length++;
+    }
+    text[length] = '\0';
+    char *parsed = NULL;
+    value_ = strtod(text, &parsed);
+    if( length == 0 || parsed != text + length )
+        return false;
+    cursor_.p += length;
+    return true;
+}
+
+/**
+ * @brief skip_json_value Skips a JSON value of any type.
+ * @param cursor_ Position, moved past the value.
+ * @param depth_  Nesting depth, deeply nested values are refused.
+ * @return        False if there is no valid value at the position.
+ */
+static bool skip_json_value(JsonCursor &cursor_, int depth_)
+{
+    std::string text;
+    double number = 0.0;
+    cursor_.skip_whitespace();
+    if( cursor_.p >= cursor_.end || depth_ > 64 )
+        return false;
+    char c = *cursor_.p;
+    if( c == '"' )
+        return read_json_string(cursor_, text);
+    if( c == '{' || c == '[' )
+    {
+        char close = c == '{' ? '}' : ']';
+        cursor_.p++;
+        if( cursor_.accept(close) )
+            return true;
+        do
+        {
+            if( c == '{' && !(read_json_string(cursor_, text) && cursor_.accept(':')) )
+                return false;
+            if( !skip_json_value(cursor_, depth_+1) )
+                return false;
+        } while( cursor_.accept(',') );
+        return cursor_.accept(close);
+    }
+    const char *literals[3] = {"true", "false", "null"};
+    for( int l=0; l<3; l++ )
+    {
+        size_t length = strlen(literals[l]);
+        if( (size_t)(cursor_.end - cursor_.p) >= length
+                && strncmp(cursor_.p, literals[l], length) == 0 )
+        {
+            cursor_.p += length;
+            return true;
+        }
+    }
+    return read_json_number(cursor_, number);
+}
+
+/**
+ * @brief read_json_edges Reads the edges of a network written by Graph::print_json.
+ * Members of the objects may be in any order, unknown members are skipped.
+ * @param cursor_  Position at the top level object.
+ * @param keys_    Source and target labels of the edges, separated by a newline.
+ * @param offsets_ Points of edge i are points_[offsets_[i]] ... points_[offsets_[i+1]-1].
+ * @param points_  Points of the edge polylines, including their end points.
+ * @return         False if the text is not valid or an edge has less than 2 points.
+ */
+static bool read_json_edges(JsonCursor &cursor_, std::vector<std::string> &keys_,
+                            std::vector<size_t> &offsets_,
+                            std::vector<meerkat::mk_vector2> &points_)
+{
+    std::string member, source, target;
+    offsets_.assign(1, 0);
+    if( !cursor_.accept('{') )
+        return false;
+    do
+    {
+        if( !read_json_string(cursor_, member) || !cursor_.accept(':') )
+            return false;
+        if( member != "edges" )
+        {
+            if( !skip_json_value(cursor_, 1) )
+                return false;
+            continue;
+        }
+        if( !cursor_.accept('[') )
+            return false;
+        if( cursor_.accept(']') )
+            continue;
+        do
+        {
+            if( !cursor_.accept('{') )
+                return false;
+            do
+            {
+                if( !read_json_string(cursor_, member) || !cursor_.accept(':') )
+                    return false;
+                bool ok = true;
+                if( member == "source" )
+                    ok = read_json_string(cursor_, source);
+                else if( member == "target" )
+                    ok = read_json_string(cursor_, target);
+                else if( member == "coords" )
+                {
+                    ok = cursor_.accept('[');
+                    while( ok && !cursor_.accept(']') )
+                    {
+                        double x = 0.0, y = 0.0;
+                        std::string coordinate;
+                        ok = cursor_.accept('{');
+                        do
+                        {
+                            ok = ok && read_json_string(cursor_, coordinate) && cursor_.accept(':');
+                            if( ok && coordinate == "x" )
+                                ok = read_json_number(cursor_, x);
+                            else if( ok && coordinate == "y" )
+                                ok = read_json_number(cursor_, y);
+                            else
+                                ok = ok && skip_json_value(cursor_, 3);
+                        } while( ok && cursor_.accept(',') );
+                        ok = ok && cursor_.accept('}');
+                        points_.push_back(meerkat::mk_vector2(x, y));
+                        cursor_.accept(',');
+                    }
+                }
+                else
+                    ok = skip_json_value(cursor_, 2);
+                if( !ok )
+                    return false;
+            } while( cursor_.accept(',') );
+            if( !cursor_.accept('}') || points_.size() - offsets_.back() < 2 )
+                return false;
+            keys_.push_back(source + "\n" + target);
+            offsets_.push_back(points_.size());
+        } while( cursor_.accept(',') );
+        if( !cursor_.accept(']') )
+            return false;
+    } while( cursor_.accept(',') );
+    return cursor_.accept('}');
+}
+
+bool Graph::warm_start(std::string file_, int cycles_)
+{
+    meerkat::mk_mapped_file file;
+    if( !file.open(file_) )
+    {
+        _log.e("warm_start", "could not read previous result");
+        return false;
+    }
+    std::vector<std::string> keys;
+    std::vector<size_t> offsets;
+    std::vector<meerkat::mk_vector2> points;
+    JsonCursor cursor = {file.data(), file.data() + file.size()};
+    if( !read_json_edges(cursor, keys, offsets, points) )
+    {
+        _log.e("warm_start", "invalid previous result");
+        return false;
+    }
+
+    // edges are matched by their labels in either direction, parallel edges in order
+    std::unordered_map<std::string, std::vector<int> > previousEdges;
+    for( int k=(int)keys.size()-1; k>=0; k-- )
+    {
+        size_t separator = keys[k].find('\n');
+        std::string source = keys[k].substr(0, separator), target = keys[k].substr(separator+1);
+        previousEdges[std::min(source, target) + "\n" + std::max(source, target)].push_back(k);
+    }
+    int edgesNum = (int)_edges.size();
+    std::vector<int> matches(edgesNum, -1);
+    int matchedNum = 0;
+    for( int i=0; i<edgesNum; i++ )
+    {
+        std::string source = node_label(_edges[i]._source), target = node_label(_edges[i]._target);
+        std::unordered_map<std::string, std::vector<int> >::iterator it
+                = previousEdges.find(std::min(source, target) + "\n" + std::max(source, target));
+        if( it != previousEdges.end() && !it->second.empty() )
+        {
+            matches[i] = it->second.back();
+            it->second.pop_back();
+            matchedNum++;
+        }
+    }
+
+    start_from(matches, offsets, points, cycles_);
+    _log.i("warm_start", "%i of %i edges start from the previous result, %i cycles left",
+           matchedNum, edgesNum, _cycles);
+    return true;
+}
+
+/**
+ * @brief compatibility Calculates the compatibility of two edges.
+ * @param edge1_ First edge.
+ * @param edge2_ Second edge.
+ * @return       Product of the angle, scale, position and visibility compatibilities.
+ */
+static double compatibility(Edge &edge1_, Edge &edge2_)
+{
+    return Edge::angle_compatilibity(edge1_, edge2_)
+            * Edge::scale_compatibility(edge1_, edge2_)
+            * Edge::position_compatibility(edge1_, edge2_)
+            * Edge::visibility_compability(edge1_, edge2_);
+}
+
+/**
+ * @brief make_lists Creates the compatibility lists from the compatible pairs.
+ * @param pairs_    Compatible pairs (i, j) with i < j, in increasing order.
+ * @param edgesNum_ Number of edges.
+ * @return          Lists, each in increasing order.
+ */
+static std::shared_ptr<CompatibilityLists> make_lists(const std::vector<std::pair<int, int> > &pairs_,
+                                                      int edgesNum_)
+{
+    std::shared_ptr<CompatibilityLists> lists(new CompatibilityLists);
+    lists->offsets.assign(edgesNum_+1, 0);
+    for( size_t p=0; p<pairs_.size(); p++ )
+    {
+        lists->offsets[pairs_[p].first+1]++;
+        lists->offsets[pairs_[p].second+1]++;
+    }
+    for( int i=0; i<edgesNum_; i++ )
+        lists->offsets[i+1] += lists->offsets[i];
+    lists->edges.resize(lists->offsets[edgesNum_]);
+    std::vector<int> filled(lists->offsets.begin(), lists->offsets.end()-1);
+    for( size_t p=0; p<pairs_.size(); p++ )
+    {
+        lists->edges[filled[pairs_[p].first]++] = pairs_[p].second;
+        lists->edges[filled[pairs_[p].second]++] = pairs_[p].first;
+    }
+    return lists;
+}
+
+void Graph::start_from(const std::vector<int> &matches_, const std::vector<size_t> &offsets_,
+                       const std::vector<meerkat::mk_vector2> &points_, int cycles_)
+{
+    // the first cycles of the schedule are skipped
+    int skippedNum = std::max(0, _cycles - std::max(1, cycles_));
+    for( int c=0; c<skippedNum; c++ )
+    {
+        _S *= 0.5;
+        _I = 2*_I/3;
+    }
+    _iter = _I;
+    _cycles -= skippedNum;
+
+    // new edges start straight
+    int edgesNum = (int)_edges.size();
+    int subdivsNum = 1 << skippedNum;
+    #pragma omp parallel for schedule(static)
+    for( int i=0; i<edgesNum; i++ )
+    {
+        if( matches_[i] >= 0 )
+            _edges[i].resample(&points_[offsets_[matches_[i]]],
+                               (int)(offsets_[matches_[i]+1] - offsets_[matches_[i]]), subdivsNum);
+        else
+        {
+            meerkat::mk_vector2 line[2] = {_edges[i]._start, _edges[i]._end};
+            _edges[i].resample(line, 2, subdivsNum);
+        }
+    }
+}
+
+/**
+ * @brief end_points_key Creates a key of the end points of an edge regardless of its
+ *                       direction.
+ * @param edge_ Edge.
+ * @return      Smaller and larger node index in the upper and lower half.
+ */
+static uint64_t end_points_key(const Edge &edge_)
+{
+    return ((uint64_t)std::min(edge_._source, edge_._target) << 32)
+            | std::max(edge_._source, edge_._target);
+}
+
+int Graph::follow(const Graph &previous_, int cycles_)
+{
+    // edges are matched by their end points in either direction as in warm_start,
+    // parallel edges in order, reversed polylines are turned around by resampling
+    std::unordered_map<uint64_t, std::vector<int> > previousEdges;
+    int previousNum = (int)previous_._edges.size();
+    for( int k=previousNum-1; k>=0; k-- )
+        previousEdges[end_points_key(previous_._edges[k])].push_back(k);
+    int edgesNum = (int)_edges.size();
+    std::vector<int> matches(edgesNum, -1), currentEdges(previousNum, -1), newEdges;
+    for( int i=0; i<edgesNum; i++ )
+    {
+        std::unordered_map<uint64_t, std::vector<int> >::iterator it
+                = previousEdges.find(end_points_key(_edges[i]));
+        if( it != previousEdges.end() && !it->second.empty() )
+        {
+            matches[i] = it->second.back();
+            currentEdges[matches[i]] = i;
+            it->second.pop_back();
+        }
+        else
+            newEdges.push_back(i);
+    }
+
+    // compatibility only depends on the end points, so pairs of continued edges are
+    // taken from the previous lists and only new edges are tested
+    if( !previous_._compatibility )
+        build_compatibility_lists();
+    else
+    {
+        const CompatibilityLists &lists = *previous_._compatibility;
+        std::vector<std::pair<int, int> > pairs;
+        for( int i=0; i<edgesNum; i++ )
+        {
+            if( matches[i] < 0 )
+                continue;
+            for( int k=lists.offsets[matches[i]]; k<lists.offsets[matches[i]+1]; k++ )
+            {
+                int j = currentEdges[lists.edges[k]];
+                if( j > i )
+                    pairs.push_back(std::make_pair(i, j));
+            }
+        }
+        for( size_t n=0; n<newEdges.size(); n++ )
+        {
+            int i = newEdges[n];
+            for( int j=0; j<edgesNum; j++ )
+            {
+                // pairs of new edges are tested once
+                if( j == i || (matches[j] < 0 && j < i) )
+                    continue;
+                if( compatibility(_edges[i], _edges[j]) >= _compatibilityThreshold )
+                    pairs.push_back(std::make_pair(std::min(i, j), std::max(i, j)));
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        _compatibility = make_lists(pairs, edgesNum);
+    }
+
+    // polylines of the previous frame with their end points
+    std::vector<size_t> offsets(previousNum+1, 0);
+    for( int k=0; k<previousNum; k++ )
+        offsets[k+1] = offsets[k] + previous_._edges[k]._subdivs.size() + 2;
+    std::vector<meerkat::mk_vector2> points(offsets[previousNum]);
+    #pragma omp parallel for schedule(static)
+    for( int k=0; k<previousNum; k++ )
+    {
+        const Edge &edge = previous_._edges[k];
+        size_t p = offsets[k];
+        points[p++] = edge._start;
+        for( size_t s=0; s<edge._subdivs.size(); s++ )
+            points[p++] = edge._subdivs[s];
+        points[p] = edge._end;
+    }
+    start_from(matches, offsets, points, cycles_);
+
+    // continued edges keep their previous shape unless their compatible edges changed
+    int frozenNum = 0;
+    _frozen.assign(edgesNum, -1);
+    if( previous_._compatibility )
+    {
+        const CompatibilityLists &lists = *previous_._compatibility;
+        for( int i=0; i<edgesNum; i++ )
+        {
+            if( matches[i] < 0 || _compatibility->offsets[i+1] - _compatibility->offsets[i]
+                    != lists.offsets[matches[i]+1] - lists.offsets[matches[i]] )
+                continue;
+            bool unchanged = true;
+            for( int k=_compatibility->offsets[i]; k<_compatibility->offsets[i+1] && unchanged; k++ )
+                unchanged = matches[_compatibility->edges[k]] >= 0;
+            if( unchanged )
+            {
+                _frozen[i] = matches[i];
+                frozenNum++;
+            }
+        }
+    }
+    if( frozenNum > 0 )
+    {
+        _frozenOffsets.swap(offsets);
+        _frozenPoints.swap(points);
+    }
+    else
+        _frozen.clear();
+    _log.i("follow", "%i of %i edges continue from the previous frame, %i of them frozen, "
+           "%i cycles left", edgesNum - (int)newEdges.size(), edgesNum, frozenNum, _cycles);
+    return edgesNum - (int)newEdges.size();
+}
+
+void Graph::set_time_budget(double seconds_)
+{
+    _timeBudget = seconds_;
+}
+
+void Graph::set_stop_flag(const std::atomic<bool> *flag_)
+{
+    _stopFlag = flag_;
+}
+
+void Graph::set_severity_level(meerkat::mk_log::SeverityLevel severityLevel_)
+{
+    _log.severity_level(severityLevel_);
+}
+
+void Graph::set_memory_limit(size_t bytes_)
+{
+    _memoryLimit = bytes_;
+}
+
+size_t Graph::memory_estimate() const
+{
+    // subdivisions are reserved for the last cycle, forces are at most as many
+    size_t pointsNum = _edges.size() * ((size_t)1 << _cycles);
+    size_t compatibleNum = _compatibility ? _compatibility->edges.size() : 0;
+    return 2 * pointsNum * sizeof(meerkat::mk_vector2)
+            + compatibleNum * sizeof(int)
+            + _edges.size() * (sizeof(Edge) + sizeof(EdgeRecord))
+            + _nodes.size() * sizeof(Node);
+}
+
+void Graph::set_graphics_params(double alpha_)
+{
+    _edgeOpacity = alpha_;
+}
+
+void Graph::set_output_params(bool compactJson_, int precision_)
+{
+    _compactJson = compactJson_;
+    _precision = precision_;
+}
+
+// Node line: label x y
+struct NodeLine
+{
+    const char *label;
+    size_t labelLength;
+    double x, y;
+};
+
+// Edge line: source target [weight]
+struct EdgeLine
+{
+    const char *source, *target;
+    size_t sourceLength, targetLength;
+    double weight;
+};
+
+static bool parse_node(meerkat::mk_tokenizer &tokenizer_, NodeLine &node_)
+{
+    const char *x, *y;
+    size_t xLength, yLength;
+    return tokenizer_.next_token(node_.label, node_.labelLength)
+            && tokenizer_.next_token(x, xLength)
+            && tokenizer_.next_token(y, yLength)
+            && meerkat::mk_tokenizer::parse_double(x, xLength, node_.x)
+            && meerkat::mk_tokenizer::parse_double(y, yLength, node_.y);
+}
+
+static bool parse_edge(meerkat::mk_tokenizer &tokenizer_, EdgeLine &edge_)
+{
+    const char *w;
+    size_t wLength;
+    if( !tokenizer_.next_token(edge_.source, edge_.sourceLength)
+            || !tokenizer_.next_token(edge_.target, edge_.targetLength) )
+        return false;
+    edge_.weight = 1.0;
+    if( tokenizer_.next_token(w, wLength) )
+        return meerkat::mk_tokenizer::parse_double(w, wLength, edge_.weight);
+    return true;
+}
+
+// Keeps every node
+struct NodeFilter
+{
+    bool operator()(const NodeLine &) { return true; }
+    void merge(const NodeFilter &) {}
+};
+
+// Drops edges not above the weight threshold, counts all edges and their maximal width
+struct EdgeFilter
+{
+    double minWidth;                // Edges with a width not above this are dropped.
+    int edgesNum;                   // Number of all edges seen.
+    double maxWidth;                // Maximum width of all edges seen.
+
+    EdgeFilter(double minWidth_) : minWidth(minWidth_), edgesNum(0), maxWidth(-HUGE_VAL) {}
+
+    bool keep(double weight_)
+    {
+        edgesNum++;
+        maxWidth = std::max(maxWidth, weight_ + 1.0);
+        return minWidth <= 0.0 || weight_ + 1.0 > minWidth;
+    }
+
+    bool operator()(const EdgeLine &edge_) { return keep(edge_.weight); }
+
+    void merge(const EdgeFilter &filter_)
+    {
+        edgesNum += filter_.edgesNum;
+        maxWidth = std::max(maxWidth, filter_.maxWidth);
+    }
+};
+
+/**
+ * @brief parse_records Parses all lines of a mapped file except for the header.
+ * Large files are split into line-aligned chunks that are parsed in parallel and
+ * concatenated in order. Each chunk filters its records with its own copy of the
+ * filter, the copies are merged into the original afterwards.
+ * @param file_         Mapped file.
+ * @param records_      Parsed records that passed the filter.
+ * @param parse_        Line parser.
+ * @param filter_       Record filter.
+ * @return              Number of lines that could not be parsed.
+ */
+template<typename Record, typename Filter>
+static int parse_records(meerkat::mk_mapped_file &file_, std::vector<Record> &records_,
+                         bool (*parse_)(meerkat::mk_tokenizer &, Record &),
+                         Filter &filter_)
+{
+    int chunksNum = file_.size() > PARALLEL_PARSE_MIN_BYTES ? thread_count() : 1;
+    std::vector<size_t> bounds;
+    file_.split_lines(chunksNum, bounds);
+
+    std::vector<std::vector<Record> > chunks(chunksNum);
+    std::vector<Filter> filters(chunksNum, filter_);
+    std::vector<int> invalid(chunksNum, 0);
+    #pragma omp parallel for schedule(static, 1)
+    for( int c=0; c<chunksNum; c++ )
+    {
+        meerkat::mk_tokenizer tokenizer(file_.data()+bounds[c], file_.data()+bounds[c+1]);
+        // first line is the header
+        if( c == 0 )
+            tokenizer.next_line();
+        Record record;
+        const char *token;
+        size_t length;
+        while( !tokenizer.at_end() )
+        {
+            meerkat::mk_tokenizer line = tokenizer;
+            if( parse_(tokenizer, record) )
+            {
+                if( filters[c](record) )
+                    chunks[c].push_back(record);
+            }
+            else if( line.next_token(token, length) )
+                invalid[c]++;
+            tokenizer.next_line();
+        }
+    }
+
+    int invalidNum = 0;
+    records_.clear();
+    for( int c=0; c<chunksNum; c++ )
+    {
+        records_.insert(records_.end(), chunks[c].begin(), chunks[c].end());
+        filter_.merge(filters[c]);
+        invalidNum += invalid[c];
+    }
+    return invalidNum;
+}
+
+/**
+ * @brief parse_index Parses a label as a non-negative integer without leading zeros.
+ * @param label_  First character of the label.
+ * @param length_ Length of the label.
+ * @param index_  Parsed integer.
+ * @return        True if the label is such an integer.
+ */
+static bool parse_index(const char *label_, size_t length_, uint32_t &index_)
+{
+    if( length_ == 0 || length_ > 9 || (label_[0] == '0' && length_ > 1) )
+        return false;
+    uint32_t index = 0;
+    for( size_t i=0; i<length_; i++ )
+    {
+        if( label_[i] < '0' || label_[i] > '9' )
+            return false;
+        index = 10*index + (uint32_t)(label_[i] - '0');
+    }
+    index_ = index;
+    return true;
+}
+
+/**
+ * @brief compare_edge_records Orders edge records by decreasing weight.
+ * @param edge1_ First edge record.
+ * @param edge2_ Second edge record.
+ * @return       True if the first record is heavier.
+ */
+static bool compare_edge_records(const EdgeRecord &edge1_, const EdgeRecord &edge2_)
+{
+    return edge1_.weight > edge2_.weight;
+}
+
+bool Graph::is_binary(std::string file_)
+{
+    // peeking into a pipe would consume its content, pipes are read as text
+    struct stat status;
+    if( stat(file_.c_str(), &status) != 0 || !S_ISREG(status.st_mode) )
+        return false;
+    char magic[8];
+    FILE *p = fopen(file_.c_str(), "rb");
+    if( p == NULL )
+        return false;
+    bool binary = fread(magic, 1, 8, p) == 8 && memcmp(magic, GRAPH_FILE_MAGIC, 8) == 0;
+    fclose(p);
+    return binary;
+}
+
+bool Graph::read(std::string nodesFile_, std::string edgesFile_, bool buildCompatibility_)
+{
+    _log.i("read", "loading network");
+    // weights are only known after merging
+    EdgeFilter filter(_mergeEdges ? -1.0 : _edgeWeightThreshold);
+    bool ok = is_binary(nodesFile_)
+            ? read_binary(nodesFile_, _records, filter)
+            : read_text(nodesFile_, edgesFile_, _records, filter);
+    if( !ok )
+        return false;
+    if( filter.edgesNum == 0 )
+    {
+        _log.e("read", "no edges found");
+        return false;
+    }
+    return prepare(filter, buildCompatibility_);
+}
+
+bool Graph::load(const double *coords_, uint32_t nodesNum_,
+                 const uint32_t *edges_, const double *weights_, uint32_t edgesNum_,
+                 bool buildCompatibility_)
+{
+    _records.resize(edgesNum_);
+    for( uint32_t r=0; r<edgesNum_; r++ )
+    {
+        _records[r].source = edges_[2*r];
+        _records[r].target = edges_[2*r+1];
+        _records[r].weight = weights_ != NULL ? weights_[r] : 1.0;
+    }
+    return load_records(coords_, nodesNum_, buildCompatibility_);
+}
+
+bool Graph::load(const double *coords_, uint32_t nodesNum_,
+                 const EdgeRecord *records_, uint32_t edgesNum_,
+                 bool buildCompatibility_)
+{
+    _records.assign(records_, records_ + edgesNum_);
+    return load_records(coords_, nodesNum_, buildCompatibility_);
+}
+
+bool Graph::load_records(const double *coords_, uint32_t nodesNum_, bool buildCompatibility_)
+{
+    _nodes.resize(nodesNum_);
+    for( uint32_t i=0; i<nodesNum_; i++ )
+        _nodes[i] = Node(coords_[2*i], coords_[2*i+1]);
+    _nodeIndex.clear();
+    _integerLabels = true;
+
+    EdgeFilter filter(_mergeEdges ? -1.0 : _edgeWeightThreshold);
+    int recordsNum = (int)_records.size(), keptNum = 0;
+    for( int r=0; r<recordsNum; r++ )
+    {
+        if( _records[r].source >= nodesNum_ || _records[r].target >= nodesNum_ )
+        {
+            _log.e("load", "edge %i refers to an unknown node", r);
+            return false;
+        }
+        if( filter.keep(_records[r].weight) )
+            _records[keptNum++] = _records[r];
+    }
+    _records.resize(keptNum);
+    if( filter.edgesNum == 0 )
+    {
+        _log.e("load", "no edges found");
+        return false;
+    }
+    if( !prepare(filter, buildCompatibility_) )
+        return false;
+    if( _edges.empty() )
+    {
+        _log.e("load", "no edges are kept by the filters");
+        return false;
+    }
+    return true;
+}
+
+bool Graph::prepare(EdgeFilter &filter_, bool buildCompatibility_)
+{
+    if( _mergeEdges )
+    {
+        int mergedNum = merge_edges(_records);
+        _log.i("read", "merged %i parallel and anti-parallel edges", mergedNum);
+        filter_ = EdgeFilter(_edgeWeightThreshold);
+        int keptNum = 0;
+        for( int r=0; r<(int)_records.size(); r++ )
+        {
+            if( filter_.keep(_records[r].weight) )
+                _records[keptNum++] = _records[r];
+        }
+        _records.resize(keptNum);
+    }
+    build_edges(_records, filter_.edgesNum, filter_.maxWidth);
+    _compatibility.reset();
+    _frozen.clear();
+    if( !check_memory() )
+        return false;
+
+    reserve_subdivisions();
+
+    // build compability lists
+    if( buildCompatibility_ )
+        build_compatibility_lists();
+    return check_memory();
+}
+
+bool Graph::check_memory()
+{
+    size_t estimate = memory_estimate();
+    if( _memoryLimit == 0 || estimate <= _memoryLimit )
+        return true;
+    _log.e("read", "network needs about %.1lf MB, more than the limit of %.1lf MB",
+           estimate / 1048576.0, _memoryLimit / 1048576.0);
+    return false;
+}
+
+bool Graph::read_text(std::string nodesFile_, std::string edgesFile_,
+                       std::vector<EdgeRecord> &records_, EdgeFilter &filter_)
+{
+    meerkat::mk_mapped_file f;
+    int invalidNum = 0;
+
+    // read nodes
+    if( !f.open(nodesFile_) )
+    {
+        _log.e("read", "could not read nodes file");
+        return false;
+    }
+    std::vector<NodeLine> nodes;
+    NodeFilter nodeFilter;
+    invalidNum = parse_records(f, nodes, parse_node, nodeFilter);
+    if( invalidNum > 0 )
+        _log.w("read", "skipped %i invalid node lines", invalidNum);
+    int nodesNum = (int)nodes.size();
+
+    // check if labels are the integers 0..N-1
+    _integerLabels = true;
+    std::vector<bool> seen(nodesNum, false);
+    for( int i=0; i<nodesNum && _integerLabels; i++ )
+    {
+        uint32_t index = 0;
+        _integerLabels = parse_index(nodes[i].label, nodes[i].labelLength, index)
+                && index < (uint32_t)nodesNum && !seen[index];
+        if( _integerLabels )
+            seen[index] = true;
+    }
+    _nodes.clear();
+    _nodeIndex.clear();
+    if( _integerLabels )
+    {
+        _nodes.resize(nodesNum);
+        for( int i=0; i<nodesNum; i++ )
+        {
+            uint32_t index = 0;
+            parse_index(nodes[i].label, nodes[i].labelLength, index);
+            _nodes[index] = Node(nodes[i].x, nodes[i].y);
+        }
+    }
+    else
+    {
+        // duplicate labels keep their first position
+        _nodeIndex.reserve(nodesNum);
+        _nodes.reserve(nodesNum);
+        for( int i=0; i<nodesNum; i++ )
+        {
+            if( _nodeIndex.insert(nodes[i].label, nodes[i].labelLength) == _nodes.size() )
+                _nodes.push_back(Node(nodes[i].x, nodes[i].y));
+        }
+    }
+    nodes.clear();
+    _log.i("read", "number of nodes: %i", (int)_nodes.size());
+    f.close();
+
+    // read edges
+    if( edgesFile_ == "" || !f.open(edgesFile_) )
+    {
+        _log.e("read", "could not read edges file");
+        return false;
+    }
+    std::vector<EdgeLine> lines;
+    invalidNum = parse_records(f, lines, parse_edge, filter_);
+    if( invalidNum > 0 )
+        _log.w("read", "skipped %i invalid edge lines", invalidNum);
+    int linesNum = (int)lines.size();
+
+    // resolve end point labels
+    std::vector<EdgeRecord> records(linesNum);
+    std::vector<char> known(linesNum);
+    #pragma omp parallel for schedule(static)
+    for( int r=0; r<linesNum; r++ )
+    {
+        records[r].weight = lines[r].weight;
+        if( _integerLabels )
+            known[r] = parse_index(lines[r].source, lines[r].sourceLength, records[r].source)
+                    && parse_index(lines[r].target, lines[r].targetLength, records[r].target)
+                    && records[r].source < _nodes.size() && records[r].target < _nodes.size();
+        else
+            known[r] = _nodeIndex.find(lines[r].source, lines[r].sourceLength, records[r].source)
+                    && _nodeIndex.find(lines[r].target, lines[r].targetLength, records[r].target);
+    }
+    lines.clear();
+    f.close();
+
+    records_.clear();
+    records_.reserve(linesNum);
+    for( int r=0; r<linesNum; r++ )
+    {
+        if( known[r] )
+            records_.push_back(records[r]);
+    }
+    if( (int)records_.size() < linesNum )
+        _log.w("read", "skipped %i edges with unknown end points", linesNum-(int)records_.size());
+    return true;
+}
+
+bool Graph::read_binary(std::string graphFile_, std::vector<EdgeRecord> &records_,
+                         EdgeFilter &filter_)
+{
+    meerkat::mk_mapped_file file;
+    if( !file.open(graphFile_) || file.size() < sizeof(GraphFileHeader) )
+    {
+        _log.e("read", "could not read graph file");
+        return false;
+    }
+    GraphFileHeader header;
+    memcpy(&header, file.data(), sizeof(GraphFileHeader));
+    if( header.version != GRAPH_FILE_VERSION || header.byteOrder != GRAPH_FILE_BYTE_ORDER )
+    {
+        _log.e("read", "unsupported graph file version or byte order");
+        return false;
+    }
+
+    // check that all sections fit in the file, sizes are bounded first so that the
+    // offsets cannot overflow
+    uint64_t nodesNum = header.nodesNum, edgesNum = header.edgesNum;
+    bool hasLabels = (header.flags & GRAPH_FILE_HAS_LABELS) != 0;
+    if( nodesNum > 0xffffffffull || edgesNum > 0x7fffffffull
+            || (hasLabels && header.labelsSize > file.size()) )
+    {
+        _log.e("read", "graph file is truncated");
+        return false;
+    }
+    uint64_t coordsOffset = sizeof(GraphFileHeader);
+    uint64_t edgesOffset = coordsOffset + 2*nodesNum*sizeof(double);
+    uint64_t labelsOffset = edgesOffset + edgesNum*sizeof(EdgeRecord);
+    uint64_t totalSize = labelsOffset;
+    if( hasLabels )
+        totalSize += (nodesNum+1)*sizeof(uint64_t) + header.labelsSize;
+    if( totalSize > file.size() )
+    {
+        _log.e("read", "graph file is truncated");
+        return false;
+    }
+
+    // nodes
+    const double *coords = (const double *)(file.data() + coordsOffset);
+    _nodes.resize(nodesNum);
+    for( uint64_t i=0; i<nodesNum; i++ )
+        _nodes[i] = Node(coords[2*i], coords[2*i+1]);
+    _nodeIndex.clear();
+    _integerLabels = !hasLabels;
+    if( hasLabels )
+    {
+        const uint64_t *offsets = (const uint64_t *)(file.data() + labelsOffset);
+        const char *labels = (const char *)(offsets + nodesNum + 1);
+        _nodeIndex.reserve(nodesNum);
+        for( uint64_t i=0; i<nodesNum; i++ )
+        {
+            if( offsets[i] > offsets[i+1] || offsets[i+1] > header.labelsSize
+                    || _nodeIndex.insert(labels + offsets[i], offsets[i+1]-offsets[i]) != i )
+            {
+                _log.e("read", "invalid label table in graph file");
+                return false;
+            }
+        }
+    }
+    _log.i("read", "number of nodes: %i", (int)_nodes.size());
+
+    // edges are filtered directly from the mapping
+    const EdgeRecord *records = (const EdgeRecord *)(file.data() + edgesOffset);
+    records_.clear();
+    for( uint64_t r=0; r<edgesNum; r++ )
+    {
+        if( records[r].source >= nodesNum || records[r].target >= nodesNum )
+        {
+            _log.e("read", "edge %i refers to an unknown node", (int)r);
+            return false;
+        }
+        if( filter_.keep(records[r].weight) )
+            records_.push_back(records[r]);
+    }
+    return true;
 }
 
-void Graph::set_physics_params(double S0_, double edgeDistance_,
-                               meerkat::mk_vector2 gravCenter_,
-                               double gravExponent_)
+int Graph::merge_edges(std::vector<EdgeRecord> &records_)
 {
-    _S = S0_;
-    _edgeDistance = edgeDistance_;
-    _gravitationCenter = gravCenter_;
-    _gravitationExponent = gravExponent_;
+    int recordsNum = (int)records_.size(), keptNum = 0;
+    std::unordered_map<uint64_t, int> firstRecords;
+    firstRecords.reserve(recordsNum);
+    for( int r=0; r<recordsNum; r++ )
+    {
+        // undirected key
+        uint64_t key = ((uint64_t)std::min(records_[r].source, records_[r].target) << 32)
+                | (uint64_t)std::max(records_[r].source, records_[r].target);
+        std::pair<std::unordered_map<uint64_t, int>::iterator, bool> first
+                = firstRecords.insert(std::make_pair(key, keptNum));
+        if( first.second )
+            records_[keptNum++] = records_[r];
+        else
+            records_[first.first->second].weight += records_[r].weight;
+    }
+    records_.resize(keptNum);
+    return recordsNum - keptNum;
 }
 
-void Graph::enable_gravitation()
+void Graph::build_edges(std::vector<EdgeRecord> &records_, int edgesNum_, double maxWidth_)
 {
-    _log.i("enable_gravitation", "gravitation is enabled");
-    _gravitationIsOn = true;
-}
+    // keep the strongest edges only
+    if( _edgeWeightThreshold <= 0.0 && _edgePercentageThreshold > 0.0 )
+    {
+        int nEdges = std::min(int(_edgePercentageThreshold * edgesNum_ / 100), (int)records_.size());
+        std::nth_element(records_.begin(), records_.begin()+nEdges, records_.end(),
+                         compare_edge_records);
+        records_.resize(nEdges);
+    }
+    std::stable_sort(records_.begin(), records_.end(), compare_edge_records);
 
-void Graph::set_graphics_params(double alpha_)
-{
-    _edgeOpacity = alpha_;
+    // create edges and normalize widths
+    int recordsNum = (int)records_.size();
+    _edges.clear();
+    _edges.reserve(recordsNum);
+    for( int r=0; r<recordsNum; r++ )
+    {
+        _edges.push_back(Edge(records_[r].source, records_[r].target,
+                              _nodes[records_[r].source]._pos,
+                              _nodes[records_[r].target]._pos,
+                              (records_[r].weight + 1.0) / (maxWidth_ + 1.0)));
+        _nodes[records_[r].source]._degree++;
+        _nodes[records_[r].target]._degree++;
+    }
+    _log.i("read", "number of edges: %i", (int)_edges.size());
 }
 
-void Graph::read(std::string nodesFile_, std::string edgesFile_)
+bool Graph::convert(std::string nodesFile_, std::string edgesFile_, std::string output_)
 {
-    _log.i("read", "loading network");
-    meerkat::mk_file_manager f;
-    int rows = 0;
-    char line[1024] = {""};
+    _log.i("convert", "loading network");
+    std::vector<EdgeRecord> records;
+    EdgeFilter filter(-1.0);
+    if( !read_text(nodesFile_, edgesFile_, records, filter) )
+        return false;
+    _log.i("convert", "number of edges: %i", (int)records.size());
 
-    // read nodes
-    if( !f.open(nodesFile_, "r") )
+    FILE *p = fopen(output_.c_str(), "wb");
+    if( p == NULL )
     {
-        _log.e("read", "could not read nodes file");
-        exit(0);
+        _log.e("convert", "could not open output file");
+        return false;
     }
-    rows = f.rows();
-    f.get_text(line, 1024);
-    char labelCh[128] = {""};
-    double x, y;
-    for( int r=1; r<rows; r++ )
+
+    // header
+    int nodesNum = (int)_nodes.size();
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(GraphFileHeader));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, 8);
+    header.version = GRAPH_FILE_VERSION;
+    header.byteOrder = GRAPH_FILE_BYTE_ORDER;
+    header.flags = _integerLabels ? 0 : GRAPH_FILE_HAS_LABELS;
+    header.nodesNum = (uint64_t)nodesNum;
+    header.edgesNum = (uint64_t)records.size();
+    std::vector<uint64_t> offsets(nodesNum+1, 0);
+    if( !_integerLabels )
     {
-        f.get_text(line, 1024);
-        sscanf(line, "%s %lg %lg", labelCh, &x, &y);
-        _nodes.insert(std::pair<std::string, Node>(std::string(labelCh), Node(x, y)));
+        for( int i=0; i<nodesNum; i++ )
+            offsets[i+1] = offsets[i] + _nodeIndex.key(i).length();
+        header.labelsSize = offsets[nodesNum];
     }
-    _log.i("read", "number of nodes: %i", (int)_nodes.size());
-    f.close();
+    bool ok = fwrite(&header, sizeof(GraphFileHeader), 1, p) == 1;
 
-    // read edges
-    if( !f.open(edgesFile_, "r") )
+    // sections
+    std::vector<double> coords(2*nodesNum);
+    for( int i=0; i<nodesNum; i++ )
     {
-        _log.e("read", "could not read edges file");
-        exit(0);
-    }
-    rows = f.rows();
-    f.get_text(line, 1024);
-    char src[128], dst[128];
-    double w, wmax = 0.0;
-    // read in all edges first
-    std::vector<Edge> allEdges;
-    for( int r=0; r<rows-1; r++)
-    {
-        f.get_text(line, 1024);
-        w = 1.0;
-        sscanf(line, "%s %s %lg", src, dst, &w);
-        allEdges.push_back(Edge(std::string(src), std::string(dst),
-                                _nodes[std::string(src)]._pos,
-                                _nodes[std::string(dst)]._pos, w + 1.0));
-    }
-    std::sort(allEdges.begin(), allEdges.end(), compare_edges );
-    wmax = allEdges[0]._width;
-    // filter out edges by weight
-    if( _edgeWeightThreshold > 0.0 )
-    {
-        for( int i=0; i<rows-1; i++ )
-        {
-            if( allEdges[i]._width > _edgeWeightThreshold )
-            {
-                _edges.push_back(allEdges[i]);
-                _nodes[allEdges[i]._sourceLabel]._degree++;
-                _nodes[allEdges[i]._targetLabel]._degree++;
-            }
-        }
+        coords[2*i] = _nodes[i]._pos.x();
+        coords[2*i+1] = _nodes[i]._pos.y();
     }
-    // filter out edges by percentage
-    else if( _edgePercentageThreshold > 0.0 )
+    ok = ok && fwrite(coords.data(), sizeof(double), coords.size(), p) == coords.size();
+    ok = ok && fwrite(records.data(), sizeof(EdgeRecord), records.size(), p) == records.size();
+    if( !_integerLabels )
     {
-        int nEdges = int(_edgePercentageThreshold * (rows-1) / 100);
-        for( int i=0; i<nEdges; i++ )
-        {
-            _edges.push_back(allEdges[i]);
-            _nodes[allEdges[i]._sourceLabel]._degree++;
-            _nodes[allEdges[i]._targetLabel]._degree++;
-        }
+        ok = ok && fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), p) == offsets.size();
+        for( int i=0; i<nodesNum && ok; i++ )
+            ok = fwrite(_nodeIndex.key(i).data(), 1, _nodeIndex.key(i).length(), p)
+                    == _nodeIndex.key(i).length();
     }
-    // if no filter option set, take all edges
-    else
+    if( fclose(p) != 0 || !ok )
     {
-        for( int i=0; i<rows-1; i++ )
-        {
-            _edges.push_back(allEdges[i]);
-            _nodes[allEdges[i]._sourceLabel]._degree++;
-            _nodes[allEdges[i]._targetLabel]._degree++;
-        }
+        _log.e("convert", "could not write output file");
+        return false;
     }
-    // normalize edge widths
-    int edgesNum = (int)_edges.size();
-    for( int i=0; i<edgesNum; i++ )
-        _edges[i]._width *= 1.0 / (wmax+1.0);
-    _log.i("read", "number of edges: %i", (int)_edges.size());
-    allEdges.clear();
-    f.close();
+    _log.i("convert", "graph is written in '%s'", output_.c_str());
+    return true;
+}
 
-    // build compability lists
-    build_compatibility_lists();
+std::string Graph::node_label(uint32_t node_) const
+{
+    if( _integerLabels )
+    {
+        char label[16];
+        sprintf(label, "%u", node_);
+        return std::string(label);
+    }
+    return _nodeIndex.key(node_);
 }
 
 void Graph::get_bounding_box(meerkat::mk_vector2 &bottomLeft_,
                              meerkat::mk_vector2 &topRight_,
                              double frame_)
 {
-    std::map<std::string, Node>::iterator it = _nodes.begin();
-    bottomLeft_ = it->second._pos;
-    topRight_ = it->second._pos;
-    it++;
+    int nodesNum = (int)_nodes.size();
+    bottomLeft_ = _nodes[0]._pos;
+    topRight_ = _nodes[0]._pos;
     double x, y;
-    for( ;
-         it != _nodes.end();
-         it++ )
+    for( int i=1; i<nodesNum; i++ )
     {
-        x = it->second._pos.x();
-        y = it->second._pos.y();
+        x = _nodes[i]._pos.x();
+        y = _nodes[i]._pos.y();
         if( x < bottomLeft_.x() )
             bottomLeft_.set_x(x);
         if( y < bottomLeft_.y() )
@@ -192,19 +1385,14 @@ void Graph::build_compatibility_lists()
     _log.i("build_compability_lists", "building lists");
 
     int edgesNum = (int)_edges.size(), compEdgePairs = 0;
-    double comp = 0.0;
+    std::vector<std::pair<int, int> > pairs;
     for( int i=0; i<edgesNum; i++ )
     {
         for( int j=i+1; j<edgesNum; j++ )
         {
-            comp = Edge::angle_compatilibity(_edges[i], _edges[j])
-                    * Edge::scale_compatibility(_edges[i], _edges[j])
-                    * Edge::position_compatibility(_edges[i], _edges[j])
-                    * Edge::visibility_compability(_edges[i], _edges[j]);
-            if( comp >= _compatibilityThreshold )
+            if( compatibility(_edges[i], _edges[j]) >= _compatibilityThreshold )
             {
-                _edges[i]._compatibleEdges.push_back(j);
-                _edges[j]._compatibleEdges.push_back(i);
+                pairs.push_back(std::make_pair(i, j));
                 compEdgePairs++;
             }
         }
@@ -213,43 +1401,75 @@ void Graph::build_compatibility_lists()
             _log.i( "build_compatibility_lists", "%i%% done, compatible edges: %i",
                     i/(edgesNum/100), compEdgePairs );
     }
+
+    _compatibility = make_lists(pairs, edgesNum);
+}
+
+std::shared_ptr<const CompatibilityLists> Graph::compatibility_lists() const
+{
+    return _compatibility;
+}
+
+bool Graph::set_compatibility_lists(std::shared_ptr<const CompatibilityLists> lists_)
+{
+    if( !lists_ || lists_->offsets.size() != _edges.size()+1 )
+        return false;
+    _compatibility = lists_;
+    return true;
 }
 
 int Graph::iterate()
 {
+    // force buffers are kept between iterations and runs
     int edgesNum = (int)_edges.size();
-    std::vector<std::vector<meerkat::mk_vector2> > forces(
-                edgesNum,
-                std::vector<meerkat::mk_vector2>(
-                    (int)_edges[0]._subdivs.size(), meerkat::mk_vector2(0.0, 0.0))
-            );
+    _forces.resize(edgesNum);
+    for( int i=0; i<edgesNum; i++ )
+        _forces[i].assign(_edges[i]._subdivs.size(), meerkat::mk_vector2(0.0, 0.0));
+
+    // frozen edges only act on the others
+    bool freezing = !_frozen.empty();
 
     // spring forces
     for( int i=0; i<edgesNum; i++ )
-        _edges[i].add_spring_forces(forces[i], _K);
+    {
+        if( !freezing || _frozen[i] < 0 )
+            _edges[i].add_spring_forces(_forces[i], _K);
+    }
 
     // electrostatic forces
-    for( int i=0; i<edgesNum; i++ )
+    if( _compatibility )
     {
-        int compatibleEdgesNum = (int)_edges[i]._compatibleEdges.size();
-        for( int j=0; j<compatibleEdgesNum; j++ )
-            _edges[i].add_electrostatic_forces(forces[i],
-                                               _edges[_edges[i]._compatibleEdges[j]],
-                                               _edgeDistance);
+        const std::vector<int> &offsets = _compatibility->offsets;
+        const std::vector<int> &compatibleEdges = _compatibility->edges;
+        for( int i=0; i<edgesNum; i++ )
+        {
+            if( freezing && _frozen[i] >= 0 )
+                continue;
+            for( int j=offsets[i]; j<offsets[i+1]; j++ )
+                _edges[i].add_electrostatic_forces(_forces[i],
+                                                   _edges[compatibleEdges[j]],
+                                                   _edgeDistance);
+        }
     }
 
     // gravitation
     if( _gravitationIsOn )
     {
         for( int i=0; i<edgesNum; i++ )
-            _edges[i].add_gravitational_forces(forces[i],
-                                               _gravitationCenter,
-                                               _gravitationExponent);
+        {
+            if( !freezing || _frozen[i] < 0 )
+                _edges[i].add_gravitational_forces(_forces[i],
+                                                   _gravitationCenter,
+                                                   _gravitationExponent);
+        }
     }
 
     // update edges
     for( int i=0; i<edgesNum; i++ )
-        _edges[i].update(forces[i], _S);
+    {
+        if( !freezing || _frozen[i] < 0 )
+            _edges[i].update(_forces[i], _S);
+    }
 
     _iter--;
     return _iter;
@@ -265,99 +1485,678 @@ int Graph::update_cycle()
     return _cycles;
 }
 
+void Graph::copy_network(const Graph &graph_)
+{
+    // storage of a previous network is reused by the assignments
+    _nodes = graph_._nodes;
+    _nodeIndex = graph_._nodeIndex;
+    _integerLabels = graph_._integerLabels;
+    _edges = graph_._edges;
+    _compatibility = graph_._compatibility;
+    _frozen.clear();
+    reserve_subdivisions();
+}
+
+double Graph::cycle_time_budget(double elapsed_, int iterationsNum_) const
+{
+    // cost of an iteration is proportional to the number of subdivision points, which
+    // doubles in each cycle while the iterations shrink
+    double points = (double)_edges[0]._subdivs.size();
+    double current = iterationsNum_ * points, rest = current;
+    int I = _I;
+    for( int c=1; c<_cycles; c++ )
+    {
+        points *= 2.0;
+        I = 2*I/3;
+        rest += I * points;
+    }
+    return rest > 0.0 ? (_timeBudget - elapsed_) * current / rest : 0.0;
+}
+
+void Graph::run()
+{
+    if( _edges.empty() )
+        return;
+    meerkat::mk_stopwatch stopwatch;
+    bool stopped = false;
+    while( !stopped )
+    {
+        int plannedNum = _iter, doneNum = 0;
+        double cycleBudget = _timeBudget > 0.0
+                ? cycle_time_budget(stopwatch.seconds(), plannedNum) : 0.0;
+        meerkat::mk_stopwatch cycleStopwatch;
+        do
+        {
+            iterate();
+            doneNum++;
+            if( _stopFlag != NULL && *_stopFlag )
+            {
+                _log.w("run", "interrupted, %i iterations left in cycle", _iter);
+                stopped = true;
+            }
+            else if( _timeBudget > 0.0 )
+            {
+                if( stopwatch.seconds() >= _timeBudget )
+                {
+                    _log.w("run", "time budget is used up, %i iterations left in cycle", _iter);
+                    stopped = true;
+                }
+                else
+                {
+                    // iterations that fit in the share of the cycle at their measured cost
+                    double cycleElapsed = cycleStopwatch.seconds();
+                    double fittingNum = cycleElapsed > 0.0
+                            ? (cycleBudget - cycleElapsed) * doneNum / cycleElapsed : _iter;
+                    if( fittingNum < _iter )
+                        _iter = fittingNum > 0.0 ? (int)fittingNum : 0;
+                }
+            }
+        } while( _iter > 0 && !stopped );
+        if( stopped )
+            break;
+        if( doneNum < plannedNum )
+            _log.i("run", "time budget: %i of %i iterations in cycle", doneNum, plannedNum);
+        add_subvisions();
+        if( update_cycle() <= 0 )
+            break;
+        if( _checkpointFile != "" )
+            checkpoint();
+    }
+    // an interrupted run can be resumed from the last iteration
+    if( stopped && _checkpointFile != "" )
+        checkpoint();
+    if( _checkpointFile != "" && !_checkpointWriter.wait() )
+        _log.w("run", "could not write checkpoint file");
+}
+
+void Graph::reserve_subdivisions()
+{
+    // subdivisions are doubled at the end of each cycle
+    int subdivsNum = 1 << _cycles;
+    int edgesNum = (int)_edges.size();
+    for( int i=0; i<edgesNum; i++ )
+        _edges[i].reserve_subdivisions(subdivsNum);
+    _subdivBuffers.resize(thread_count());
+    for( int t=0; t<(int)_subdivBuffers.size(); t++ )
+        _subdivBuffers[t].reserve(subdivsNum);
+}
+
 void Graph::add_subvisions()
 {
     _log.i("add_subdivisions", "subdividing edges");
     int edgesNum = (int)_edges.size();
-    for( int i=0; i<edgesNum; i++ )
-        _edges[i].add_subdivisions();
+    #pragma omp parallel
+    {
+        std::vector<meerkat::mk_vector2> &buffer = _subdivBuffers[thread_index()];
+        #pragma omp for schedule(static)
+        for( int i=0; i<edgesNum; i++ )
+        {
+            // frozen edges are placed along their previous shape again
+            int frozen = _frozen.empty() ? -1 : _frozen[i];
+            if( frozen >= 0 )
+                _edges[i].resample(&_frozenPoints[_frozenOffsets[frozen]],
+                                   (int)(_frozenOffsets[frozen+1] - _frozenOffsets[frozen]),
+                                   2*(int)_edges[i]._subdivs.size());
+            else
+                _edges[i].add_subdivisions(buffer);
+        }
+    }
 }
 
 void Graph::smooth()
 {
     _log.i("smooth", "applying Gaussian smoothing");
     int edgesNum = (int)_edges.size();
-    for( int i=0; i<edgesNum; i++ )
-        _edges[i].smooth(_smoothWidth);
+    if( edgesNum == 0 )
+        return;
+
+    // kernel weights truncated at 3 sigma
+    int radius = std::max(1, (int)ceil(3.0*_smoothWidth));
+    std::vector<double> kernel(radius+1);
+    for( int d=0; d<=radius; d++ )
+        kernel[d] = gauss_weight(d, _smoothWidth);
+
+    // total weights only depend on the position within the edge
+    int len = (int)_edges[0]._subdivs.size();
+    std::vector<double> norms(len);
+    for( int i=0; i<len; i++ )
+    {
+        double totalWeight = 0.0;
+        if( i+1 <= radius )
+            totalWeight += kernel[i+1];
+        for( int j=std::max(0, i-radius); j<=std::min(len-1, i+radius); j++ )
+            totalWeight += kernel[abs(i-j)];
+        if( len-i+1 <= radius )
+            totalWeight += kernel[len-i+1];
+        norms[i] = 1.0 / totalWeight;
+    }
+
+    #pragma omp parallel
+    {
+        std::vector<meerkat::mk_vector2> buffer;
+        #pragma omp for schedule(static)
+        for( int i=0; i<edgesNum; i++ )
+            _edges[i].smooth(kernel, norms, buffer);
+    }
     _log.i("smooth", "done");
 }
 
-void Graph::draw()
+void Graph::simplify(double tolerance_)
 {
-    // draw edges
-    int numEdges = (int)_edges.size();
-    for( int i=0; i<numEdges; i++ )
-        _edges[i].draw(_edgeOpacity);
+    _log.i("simplify", "simplifying edges");
+    int edgesNum = (int)_edges.size();
+    long long pointsBefore = 0, pointsAfter = 0;
+    #pragma omp parallel reduction(+:pointsBefore, pointsAfter)
+    {
+        std::vector<char> keep;
+        std::vector<int> stack;
+        #pragma omp for schedule(dynamic, 64)
+        for( int i=0; i<edgesNum; i++ )
+        {
+            pointsBefore += (long long)_edges[i]._subdivs.size() + 2;
+            _edges[i].simplify(tolerance_, keep, stack);
+            pointsAfter += (long long)_edges[i]._subdivs.size() + 2;
+        }
+    }
+    _log.i("simplify", "points: %lld -> %lld (reduction ratio: %.2lf)",
+           pointsBefore, pointsAfter,
+           pointsAfter > 0 ? double(pointsBefore) / double(pointsAfter) : 0.0);
+}
 
-    // draw nodes
-    for( std::map<std::string, Node>::iterator it = _nodes.begin();
-         it != _nodes.end();
-         it++ )
-        it->second.draw();
+const std::vector<Node> &Graph::nodes() const
+{
+    return _nodes;
 }
 
-void Graph::print_json(std::string output_)
+const std::vector<Edge> &Graph::edges() const
 {
-    FILE *p = fopen(output_.c_str(), "w");
-    if( p == NULL )
+    return _edges;
+}
+
+double Graph::edge_opacity() const
+{
+    return _edgeOpacity;
+}
+
+void Graph::get_polylines(std::vector<float> &points_, std::vector<int> &counts_) const
+{
+    int edgesNum = (int)_edges.size();
+    counts_.resize(edgesNum);
+    size_t pointsNum = 0;
+    for( int i=0; i<edgesNum; i++ )
+    {
+        counts_[i] = (int)_edges[i]._subdivs.size() + 2;
+        pointsNum += counts_[i];
+    }
+    points_.resize(2*pointsNum);
+
+    float *p = points_.data();
+    for( int i=0; i<edgesNum; i++ )
+    {
+        const Edge &edge = _edges[i];
+        *p++ = (float)edge._start.x();
+        *p++ = (float)edge._start.y();
+        int len = (int)edge._subdivs.size();
+        for( int j=0; j<len; j++ )
+        {
+            *p++ = (float)edge._subdivs[j].x();
+            *p++ = (float)edge._subdivs[j].y();
+        }
+        *p++ = (float)edge._end.x();
+        *p++ = (float)edge._end.y();
+    }
+}
+
+// Separators of the JSON output
+struct JsonStyle
+{
+    const char *begin, *label, *x, *y, *nodeEnd, *separator, *edges,
+               *source, *target, *coords, *pointX, *pointY, *pointEnd,
+               *pointSeparator, *coordsEnd, *end;
+};
+
+static const JsonStyle PRETTY_JSON = {
+    "{\n  \"nodes\" : [\n",
+    "    {\n      \"label\" : ", ",\n      \"x\" : ", ",\n      \"y\" : ", "\n    }",
+    ",\n",
+    "\n  ],\n  \"edges\" : [\n",
+    "    {\n      \"source\" : ", ",\n      \"target\" : ", ",\n      \"coords\" : [\n",
+    "        { \"x\" : ", ", \"y\" : ", " }",
+    ",\n",
+    "\n      ]\n    }",
+    "\n  ]\n}"
+};
+
+static const JsonStyle COMPACT_JSON = {
+    "{\"nodes\":[",
+    "{\"label\":", ",\"x\":", ",\"y\":", "}",
+    ",",
+    "],\"edges\":[",
+    "{\"source\":", ",\"target\":", ",\"coords\":[",
+    "{\"x\":", ",\"y\":", "}",
+    ",",
+    "]}",
+    "]}"
+};
+
+/**
+ * @brief append_json_string Appends a quoted and escaped JSON string.
+ * @param text_  Text to extend.
+ * @param value_ String to append.
+ */
+static void append_json_string(std::string &text_, const std::string &value_)
+{
+    text_ += '"';
+    for( size_t i=0; i<value_.length(); i++ )
+    {
+        unsigned char c = (unsigned char)value_[i];
+        if( c == '"' || c == '\\' )
+        {
+            text_ += '\\';
+            text_ += (char)c;
+        }
+        else if( c < 0x20 )
+        {
+            char escaped[8];
+            sprintf(escaped, "\\u%04x", c);
+            text_ += escaped;
+        }
+        else
+            text_ += (char)c;
+    }
+    text_ += '"';
+}
+
+static void append_json_point(std::string &text_, const JsonStyle &style_,
+                              const meerkat::mk_vector2 &point_, int precision_)
+{
+    text_ += style_.pointX;
+    meerkat::mk_buffered_writer::append_double(text_, point_.x(), precision_);
+    text_ += style_.pointY;
+    meerkat::mk_buffered_writer::append_double(text_, point_.y(), precision_);
+    text_ += style_.pointEnd;
+}
+
+static void append_svg_point(std::string &text_, const meerkat::mk_vector2 &point_, int precision_)
+{
+    text_ += ' ';
+    meerkat::mk_buffered_writer::append_double(text_, point_.x(), precision_);
+    text_ += ' ';
+    meerkat::mk_buffered_writer::append_double(text_, -point_.y(), precision_);
+}
+
+bool Graph::print_json(std::string output_)
+{
+    meerkat::mk_buffered_writer w;
+    if( !w.open(output_) )
     {
         _log.e("print_json", "could not open output file");
-        exit(0);
+        return false;
     }
+    const JsonStyle &style = _compactJson ? COMPACT_JSON : PRETTY_JSON;
+    std::string text;
 
     // nodes
-    fprintf( p, "{\n  \"nodes\" : [\n" );
-    int numNodes = (int)_nodes.size(), nodeId = 0;
-    for( std::map<std::string, Node>::iterator it = _nodes.begin();
-         it != _nodes.end();
-         it++ )
-    {
-        fprintf( p, "    {\n" );
-        fprintf( p, "      \"label\" : \"%s\",\n", it->first.c_str() );
-        fprintf( p, "      \"x\" : %lg,\n", it->second._pos.x() );
-        fprintf( p, "      \"y\" : %lg\n", it->second._pos.y() );
-        if( nodeId < numNodes-1 )
-            fprintf( p, "    },\n");
-        else
-            fprintf( p, "    }\n" );
-        nodeId++;
+    w.put( style.begin );
+    int numNodes = (int)_nodes.size();
+    for( int i=0; i<numNodes; i++ )
+    {
+        text.clear();
+        if( i > 0 )
+            text += style.separator;
+        text += style.label;
+        append_json_string(text, node_label(i));
+        text += style.x;
+        meerkat::mk_buffered_writer::append_double(text, _nodes[i]._pos.x(), _precision);
+        text += style.y;
+        meerkat::mk_buffered_writer::append_double(text, _nodes[i]._pos.y(), _precision);
+        text += style.nodeEnd;
+        w.put( text );
     }
-    fprintf( p, "  ],\n" );
+    w.put( style.edges );
 
-    // edges
-    fprintf( p, "  \"edges\" : [\n" );
-    int numEdges = (int)_edges.size(), len;
-    for( int i=0; i<numEdges; i++ )
+    // edges are formatted in parallel chunks and written in order
+    int numEdges = (int)_edges.size();
+    int chunksNum = 4*thread_count();
+    std::vector<std::string> chunks(chunksNum);
+    for( int first=0; first<numEdges; first+=chunksNum*JSON_CHUNK_EDGES )
     {
-        fprintf( p, "    {\n" );
-        fprintf( p, "      \"source\" : \"%s\",\n", _edges[i]._sourceLabel.c_str() );
-        fprintf( p, "      \"target\" : \"%s\",\n", _edges[i]._targetLabel.c_str() );
-        fprintf( p, "      \"coords\" : [\n" );
-        fprintf( p, "        { \"x\" : %lg, \"y\" : %lg },\n",
-                 _edges[i]._start.x(), _edges[i]._start.y() );
-        len = (int)_edges[i]._subdivs.size();
-        for( int j=0; j<len; j++ )
+        #pragma omp parallel for schedule(dynamic, 1)
+        for( int c=0; c<chunksNum; c++ )
         {
-            fprintf( p, "        { \"x\" : %lg, \"y\" : %lg },\n",
-                     _edges[i]._subdivs[j].x(), _edges[i]._subdivs[j].y() );
+            chunks[c].clear();
+            int chunkFirst = first + c*JSON_CHUNK_EDGES;
+            int chunkLast = std::min(chunkFirst + JSON_CHUNK_EDGES, numEdges);
+            for( int i=chunkFirst; i<chunkLast; i++ )
+            {
+                if( i > 0 )
+                    chunks[c] += style.separator;
+                chunks[c] += style.source;
+                append_json_string(chunks[c], node_label(_edges[i]._source));
+                chunks[c] += style.target;
+                append_json_string(chunks[c], node_label(_edges[i]._target));
+                chunks[c] += style.coords;
+                append_json_point(chunks[c], style, _edges[i]._start, _precision);
+                int len = (int)_edges[i]._subdivs.size();
+                for( int j=0; j<len; j++ )
+                {
+                    chunks[c] += style.pointSeparator;
+                    append_json_point(chunks[c], style, _edges[i]._subdivs[j], _precision);
+                }
+                chunks[c] += style.pointSeparator;
+                append_json_point(chunks[c], style, _edges[i]._end, _precision);
+                chunks[c] += style.coordsEnd;
+            }
         }
-        fprintf( p, "        { \"x\" : %lg, \"y\" : %lg }\n",
-                 _edges[i]._end.x(), _edges[i]._end.y() );
-        fprintf( p, "      ]\n" );
-        if( i < numEdges-1 )
-            fprintf( p, "    },\n");
-        else
-            fprintf( p, "    }\n" );
+        for( int c=0; c<chunksNum; c++ )
+            w.put( chunks[c] );
+    }
+    w.put( style.end );
+    if( !w.close() )
+    {
+        _log.e("print_json", "could not write output file");
+        return false;
     }
-    fprintf( p, "  ]\n" );
-    fprintf( p, "}" );
-    fclose( p );
 
     _log.i("print_json", "network is written in '%s'", output_.c_str());
+    return true;
+}
+
+size_t Graph::polyline_header(PolylineFileHeader &header_, int scalarSize_) const
+{
+    uint64_t nodesNum = _nodes.size(), edgesNum = _edges.size(), pointsNum = 0;
+    for( uint64_t i=0; i<edgesNum; i++ )
+        pointsNum += _edges[i]._subdivs.size() + 2;
+
+    memset(&header_, 0, sizeof(PolylineFileHeader));
+    memcpy(header_.magic, POLYLINE_FILE_MAGIC, 8);
+    header_.version = POLYLINE_FILE_VERSION;
+    header_.byteOrder = POLYLINE_FILE_BYTE_ORDER;
+    header_.scalarSize = (uint32_t)scalarSize_;
+    header_.nodesNum = nodesNum;
+    header_.edgesNum = edgesNum;
+    header_.pointsNum = pointsNum;
+
+    // sections padded to 8 bytes
+    header_.nodesOffset = sizeof(PolylineFileHeader);
+    header_.endpointsOffset = header_.nodesOffset + (2*nodesNum*scalarSize_ + 7) / 8 * 8;
+    header_.offsetsOffset = header_.endpointsOffset + (2*edgesNum*sizeof(uint32_t) + 7) / 8 * 8;
+    header_.pointsOffset = header_.offsetsOffset + (edgesNum+1)*sizeof(uint64_t);
+    return (size_t)(header_.pointsOffset + 2*pointsNum*scalarSize_);
+}
+
+template<typename Scalar>
+static void store_point(Scalar *points_, uint64_t index_, const meerkat::mk_vector2 &point_)
+{
+    points_[2*index_] = (Scalar)point_.x();
+    points_[2*index_+1] = (Scalar)point_.y();
+}
+
+template<typename Scalar>
+static void fill_points(char *buffer_, const PolylineFileHeader &header_,
+                        const std::vector<Node> &nodes_, const std::vector<Edge> &edges_)
+{
+    Scalar *nodes = (Scalar *)(buffer_ + header_.nodesOffset);
+    for( uint64_t i=0; i<header_.nodesNum; i++ )
+        store_point(nodes, i, nodes_[i]._pos);
+
+    uint32_t *endpoints = (uint32_t *)(buffer_ + header_.endpointsOffset);
+    uint64_t *offsets = (uint64_t *)(buffer_ + header_.offsetsOffset);
+    offsets[0] = 0;
+    for( uint64_t i=0; i<header_.edgesNum; i++ )
+    {
+        endpoints[2*i] = edges_[i]._source;
+        endpoints[2*i+1] = edges_[i]._target;
+        offsets[i+1] = offsets[i] + edges_[i]._subdivs.size() + 2;
+    }
+
+    Scalar *points = (Scalar *)(buffer_ + header_.pointsOffset);
+    int edgesNum = (int)header_.edgesNum;
+    #pragma omp parallel for schedule(static)
+    for( int i=0; i<edgesNum; i++ )
+    {
+        uint64_t index = offsets[i];
+        int len = (int)edges_[i]._subdivs.size();
+        store_point(points, index++, edges_[i]._start);
+        for( int j=0; j<len; j++ )
+            store_point(points, index++, edges_[i]._subdivs[j]);
+        store_point(points, index, edges_[i]._end);
+    }
+}
+
+void Graph::fill_polylines(char *buffer_, const PolylineFileHeader &header_) const
+{
+    memcpy(buffer_, &header_, sizeof(PolylineFileHeader));
+    if( header_.scalarSize == sizeof(float) )
+        fill_points<float>(buffer_, header_, _nodes, _edges);
+    else
+        fill_points<double>(buffer_, header_, _nodes, _edges);
+}
+
+bool Graph::print_binary(std::string output_, int scalarSize_)
+{
+    PolylineFileHeader header;
+    size_t size = polyline_header(header, scalarSize_);
+    meerkat::mk_mapped_file f;
+    if( !f.create(output_, size) )
+    {
+        _log.e("print_binary", "could not open output file");
+        return false;
+    }
+    fill_polylines(f.data(), header);
+    if( !f.close() )
+    {
+        _log.e("print_binary", "could not write output file");
+        return false;
+    }
+
+    _log.i("print_binary", "network is written in '%s'", output_.c_str());
+    return true;
+}
+
+bool Graph::print_svg(std::string output_)
+{
+    meerkat::mk_buffered_writer w;
+    if( !w.open(output_) )
+    {
+        _log.e("print_svg", "could not open output file");
+        return false;
+    }
+
+    // y axis points downwards in SVG
+    meerkat::mk_vector2 bottomLeft, topRight;
+    get_bounding_box(bottomLeft, topRight, 20.0);
+    double gWidth = topRight.x() - bottomLeft.x();
+    double gHeight = topRight.y() - bottomLeft.y();
+    double scale = SVG_SIZE / std::max(gWidth, gHeight);
+    std::string text;
+    char header[512];
+    sprintf(header,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+            "viewBox=\"%.17g %.17g %.17g %.17g\">\n"
+            "<rect x=\"%.17g\" y=\"%.17g\" width=\"%.17g\" height=\"%.17g\" fill=\"white\"/>\n",
+            int(gWidth*scale + 0.5), int(gHeight*scale + 0.5),
+            bottomLeft.x(), -topRight.y(), gWidth, gHeight,
+            bottomLeft.x(), -topRight.y(), gWidth, gHeight);
+    w.put( header );
+
+    // edges, line widths are given in pixels as in the live view
+    text = "<g fill=\"none\" stroke=\"rgb(212,0,0)\" stroke-linecap=\"round\" stroke-opacity=\"";
+    meerkat::mk_buffered_writer::append_double(text, _edgeOpacity, 6);
+    text += "\">\n";
+    w.put( text );
+    int numEdges = (int)_edges.size();
+    for( int i=0; i<numEdges; i++ )
+    {
+        text = "<path stroke-width=\"";
+        meerkat::mk_buffered_writer::append_double(text, _edges[i].stroke_width() / scale, 6);
+        text += "\" d=\"M";
+        append_svg_point(text, _edges[i]._start, _precision);
+        text += " L";
+        int len = (int)_edges[i]._subdivs.size();
+        for( int j=0; j<len; j++ )
+            append_svg_point(text, _edges[i]._subdivs[j], _precision);
+        append_svg_point(text, _edges[i]._end, _precision);
+        text += "\"/>\n";
+        w.put( text );
+    }
+    w.put( "</g>\n" );
+
+    // nodes
+    int numNodes = (int)_nodes.size();
+    for( int i=0; i<numNodes; i++ )
+    {
+        text = "<circle cx=\"";
+        meerkat::mk_buffered_writer::append_double(text, _nodes[i]._pos.x(), _precision);
+        text += "\" cy=\"";
+        meerkat::mk_buffered_writer::append_double(text, -_nodes[i]._pos.y(), _precision);
+        text += _nodes[i]._degree == 0
+                ? "\" r=\"" SVG_NODE_RADIUS "\" fill=\"rgb(242,242,242)\"/>\n"
+                : "\" r=\"" SVG_NODE_RADIUS "\" fill=\"rgb(0,180,240)\"/>\n";
+        w.put( text );
+    }
+    w.put( "</svg>\n" );
+    if( !w.close() )
+    {
+        _log.e("print_svg", "could not write output file");
+        return false;
+    }
+
+    _log.i("print_svg", "network is written in '%s'", output_.c_str());
+    return true;
 }
 
-void Graph::print_svg(std::string output_)
+bool Graph::print_image(std::string output_, int size_, bool density_)
 {
-    //TODO
+    // PGM files hold gray density maps, PPM files color images
+    size_t length = output_.length();
+    std::string extension = length > 4 ? output_.substr(length-4) : "";
+    if( extension == ".pgm" )
+        density_ = true;
+    else if( extension == ".ppm" && density_ )
+    {
+        _log.e("print_image", "density maps are written as PGM or PNG, not PPM");
+        return false;
+    }
+
+    meerkat::mk_vector2 bottomLeft, topRight;
+    get_bounding_box(bottomLeft, topRight, 20.0);
+    double gWidth = topRight.x() - bottomLeft.x();
+    double gHeight = topRight.y() - bottomLeft.y();
+    double scale = size_ / std::max(gWidth, gHeight);
+    int width = std::max(1, int(gWidth*scale + 0.5));
+    int height = std::max(1, int(gHeight*scale + 0.5));
+
+    std::vector<unsigned char> pixels;
+    Rasterizer rasterizer(_edges, _nodes, _edgeOpacity);
+    rasterizer.render(bottomLeft, scale, width, height, density_, pixels);
+    if( !meerkat::mk_image_writer::write(output_, width, height, density_ ? 1 : 3, pixels.data()) )
+    {
+        _log.e("print_image", "could not write output file");
+        return false;
+    }
+
+    _log.i("print_image", "%dx%d image is written in '%s'", width, height, output_.c_str());
+    return true;
 }
 
+bool Graph::print_tiles(std::string directory_, int maxZoom_)
+{
+    if( maxZoom_ < 0 || maxZoom_ > TILE_MAX_ZOOM )
+    {
+        _log.e("print_tiles", "zoom level must be between 0 and %d", TILE_MAX_ZOOM);
+        return false;
+    }
+    if( !make_directory(directory_) )
+    {
+        _log.e("print_tiles", "could not create output directory");
+        return false;
+    }
+
+    // pyramid covers the square of the bounding box from its top left corner
+    meerkat::mk_vector2 bottomLeft, topRight;
+    get_bounding_box(bottomLeft, topRight, 20.0);
+    double side = std::max(topRight.x() - bottomLeft.x(), topRight.y() - bottomLeft.y());
+    double left = bottomLeft.x(), top = topRight.y();
+
+    Rasterizer rasterizer(_edges, _nodes, _edgeOpacity);
+    static const unsigned char EDGE_COLOR[3] = RASTER_EDGE_COLOR;
+    size_t tileArea = TILE_SIZE * TILE_SIZE;
+    long long tilesNum = 0;
+    for( int z=0; z<=maxZoom_; z++ )
+    {
+        std::string levelDirectory = directory_ + "/" + std::to_string(z);
+        if( !make_directory(levelDirectory) )
+        {
+            _log.e("print_tiles", "could not create output directory");
+            return false;
+        }
+
+        // segments are binned per level, so only tiles they overlap are rendered, rows of
+        // tiles are taken in bands that bound the number of binned pairs
+        int n = 1 << z;
+        double scale = TILE_SIZE * double(n) / side;
+        std::vector<size_t> rowCounts;
+        rasterizer.count_segments_sparse(left, top, scale, TILE_SIZE, n, rowCounts);
+        std::vector<uint64_t> tiles;
+        std::vector<size_t> offsets;
+        std::vector<SegmentRef> segments;
+        bool failed = false;
+        for( int rowFirst=0, rowLast=0; rowFirst<n && !failed; rowFirst=rowLast+1 )
+        {
+            size_t pairsNum = rowCounts[rowFirst];
+            for( rowLast=rowFirst; rowLast+1<n && pairsNum + rowCounts[rowLast+1] <= TILE_BAND_PAIRS; rowLast++ )
+                pairsNum += rowCounts[rowLast+1];
+            if( pairsNum == 0 )
+                continue;
+            rasterizer.bin_segments_sparse(left, top, scale, TILE_SIZE, n, rowFirst, rowLast,
+                                           tiles, offsets, segments);
+            #pragma omp parallel reduction(+: tilesNum) reduction(||: failed)
+            {
+                std::vector<float> transmittance(tileArea), density(tileArea), coverage(tileArea, 0.0f);
+                std::vector<unsigned char> pixels(4*tileArea);
+                #pragma omp for schedule(dynamic)
+                for( long long t=0; t<(long long)tiles.size(); t++ )
+                {
+                    int x = int(tiles[t] % n), y = int(tiles[t] / n);
+                    std::fill(transmittance.begin(), transmittance.end(), 1.0f);
+                    std::fill(density.begin(), density.end(), 0.0f);
+                    rasterizer.draw_edges(&segments[offsets[t]], offsets[t+1] - offsets[t],
+                                          left + x*side/n, top - y*side/n, scale,
+                                          TILE_SIZE, TILE_SIZE,
+                                          &transmittance[0], &density[0], &coverage[0]);
+                    bool empty = true;
+                    for( size_t p=0; p<tileArea; p++ )
+                    {
+                        unsigned char alpha = (unsigned char)(255.0f*(1.0f - transmittance[p]) + 0.5f);
+                        pixels[4*p] = EDGE_COLOR[0];
+                        pixels[4*p+1] = EDGE_COLOR[1];
+                        pixels[4*p+2] = EDGE_COLOR[2];
+                        pixels[4*p+3] = alpha;
+                        if( alpha > 0 )
+                            empty = false;
+                    }
+                    if( empty )
+                        continue;
+
+                    std::string columnDirectory = levelDirectory + "/" + std::to_string(x);
+                    if( !make_directory(columnDirectory)
+                            || !meerkat::mk_image_writer::write_png(columnDirectory + "/" + std::to_string(y) + ".png",
+                                                                    TILE_SIZE, TILE_SIZE, 4, &pixels[0]) )
+                        failed = true;
+                    tilesNum++;
+                }
+            }
+        }
+        if( failed )
+        {
+            _log.e("print_tiles", "could not write tiles of zoom level %d", z);
+            return false;
+        }
+    }
+
+    _log.i("print_tiles", "%lld tiles of %d zoom levels are written in '%s'",
+           tilesNum, maxZoom_+1, directory_.c_str());
+    return true;
+}
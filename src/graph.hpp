@@ -4,20 +4,65 @@
 #include "stdlib.h"
 #include <vector>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
 #include "meerkat_logger.hpp"
 #include "meerkat_file_manager.hpp"
+#include "meerkat_mapped_file.hpp"
+#include "meerkat_tokenizer.hpp"
+#include "meerkat_string_index.hpp"
+#include "meerkat_buffered_writer.hpp"
 #include "meerkat_vector2.hpp"
+#include "meerkat_image_writer.hpp"
+#include "meerkat_async_writer.hpp"
+#include "meerkat_stopwatch.hpp"
 #include "node.hpp"
 #include "edge.hpp"
+#include "rasterizer.hpp"
+#include "graph_format.hpp"
+#include "polyline_format.hpp"
+#include "checkpoint_format.hpp"
+
+#define PARALLEL_PARSE_MIN_BYTES (16 << 20)     // Files larger than this are parsed in parallel chunks.
+#define JSON_CHUNK_EDGES 256                    // Edges formatted together when writing JSON.
+#define SVG_SIZE 600                            // Size of the longer side of SVG images in pixels.
+#define SVG_NODE_RADIUS "1"                     // Radius of nodes in SVG images.
+#define MAX_CYCLES 24                           // Largest number of cycles, subdivisions double in each.
+#define TILE_SIZE 256                           // Size of pyramid tiles in pixels.
+#define TILE_MAX_ZOOM 20                        // Largest supported zoom level of the tile pyramid.
+#define TILE_BAND_PAIRS (1 << 22)               // Segment and tile pairs binned at once for the tile pyramid.
+
+struct EdgeFilter;
+
+// CompatibilityLists struct
+// Compatible edges of all edges in a single array, the compatible edges of edge i are
+// edges[offsets[i]] ... edges[offsets[i+1]-1]. Lists are immutable once built, so that
+// graphs of the same network can share them.
+struct CompatibilityLists
+{
+    std::vector<int> offsets;
+    std::vector<int> edges;
+};
 
 // Graph class
 class Graph
 {
 private:
     // Network structure
-    std::map<std::string, Node> _nodes;
+    std::vector<Node> _nodes;
+    meerkat::mk_string_index _nodeIndex;        // Node labels interned into node indices.
+    bool _integerLabels;                        // Marks whether node labels are their own indices.
     std::vector<Edge> _edges;
+    std::vector<std::vector<meerkat::mk_vector2> > _subdivBuffers;   // Per-thread resampling buffers.
+    std::vector<std::vector<meerkat::mk_vector2> > _forces;          // Forces on the subdivision points.
+    std::vector<EdgeRecord> _records;           // Edge records of the last read network.
+    std::shared_ptr<const CompatibilityLists> _compatibility;   // NULL if not built or set.
+
+    // Edges of an animation frame that keep their shape in the previous frame
+    std::vector<int> _frozen;                   // Previous polyline of each edge, -1 if bundled, empty if none.
+    std::vector<size_t> _frozenOffsets;         // Start of each previous polyline.
+    std::vector<meerkat::mk_vector2> _frozenPoints;     // Previous polylines with their end points.
 
     // Logger
     meerkat::mk_log _log;
@@ -40,10 +85,129 @@ private:
     // Network parameters
     double _edgeWeightThreshold;                // Threshold on edge weights (for dense graphs).
     double _edgePercentageThreshold;            // Percentage of edges being kept (for dense graphs).
+    bool _mergeEdges;                           // Marks whether parallel edges are merged.
+    size_t _memoryLimit;                        // Largest estimated memory of a network (0: unlimited).
 
     // Graphics parameters
     double _edgeOpacity;                        // Opacity.
 
+    // Checkpoints
+    std::string _checkpointFile;                // Written at the end of each cycle, empty if off.
+    meerkat::mk_async_writer _checkpointWriter;
+
+    // Anytime mode
+    double _timeBudget;                         // Wall-clock time of run() in seconds (0: unlimited).
+    const std::atomic<bool> *_stopFlag;         // Stops run() when set, NULL if unused.
+
+    // Output parameters
+    bool _compactJson;                          // Marks whether JSON is written without indentation.
+    int _precision;                             // Significant digits of coordinates (0: shortest round-trip).
+
+    /**
+     * @brief is_binary Checks if a file is a binary graph file.
+     * @param file_ Name of the file.
+     * @return      True if the file is a regular file starting with the binary graph magic.
+     */
+    static bool is_binary(std::string file_);
+
+    /**
+     * @brief read_text Reads nodes and edge records from text files.
+     * @param nodesFile_ Name of the node coordinates file.
+     * @param edgesFile_ Name of the edge endpoints file.
+     * @param records_   Edges with known end points that passed the filter.
+     * @param filter_    Weight filter applied while parsing.
+     * @return           False if a file could not be read.
+     */
+    bool read_text(std::string nodesFile_, std::string edgesFile_,
+                   std::vector<EdgeRecord> &records_, EdgeFilter &filter_);
+
+    /**
+     * @brief read_binary Reads nodes from a binary graph file and filters its edge
+     *                    records straight from the mapping.
+     * @param graphFile_ Name of the binary graph file.
+     * @param records_   Edge records that passed the filter.
+     * @param filter_    Weight filter.
+     * @return           False if the file could not be read or is invalid.
+     */
+    bool read_binary(std::string graphFile_, std::vector<EdgeRecord> &records_,
+                     EdgeFilter &filter_);
+
+    /**
+     * @brief merge_edges Merges parallel and anti-parallel edges into the first
+     *                    occurrence, summing their weights.
+     * @param records_ Edge records, merged in place.
+     * @return         Number of records merged into others.
+     */
+    int merge_edges(std::vector<EdgeRecord> &records_);
+
+    /**
+     * @brief prepare Merges and filters the edge records, then creates the edges
+     *                and their compatibility lists.
+     * @param filter_             Weight filter the records were read with.
+     * @param buildCompatibility_ Whether to build the compatibility lists.
+     * @return                    False if the network exceeds the memory limit.
+     */
+    bool prepare(EdgeFilter &filter_, bool buildCompatibility_);
+
+    /**
+     * @brief check_memory Checks the memory estimate of the network against the limit.
+     * @return True if the network fits in the limit.
+     */
+    bool check_memory();
+
+    /**
+     * @brief network_hash Hashes the end points of the edges to recognize the network
+     *                     of a checkpoint.
+     * @return Hash.
+     */
+    uint64_t network_hash() const;
+
+    /**
+     * @brief checkpoint Starts writing the current state into the checkpoint file in
+     *                   the background. Waits for the previous checkpoint if it is still
+     *                   being written.
+     */
+    void checkpoint();
+
+    /**
+     * @brief start_from Skips the first cycles of the schedule and resamples the edges
+     *                   from earlier polylines, edges without a polyline start straight.
+     * @param matches_ Polyline of each edge, -1 if none.
+     * @param offsets_ Points of polyline k are points_[offsets_[k]] ... points_[offsets_[k+1]-1].
+     * @param points_  Points of the polylines, including their end points.
+     * @param cycles_  Number of cycles to run.
+     */
+    void start_from(const std::vector<int> &matches_, const std::vector<size_t> &offsets_,
+                    const std::vector<meerkat::mk_vector2> &points_, int cycles_);
+
+    /**
+     * @brief cycle_time_budget Shares the remaining time budget among the remaining
+     *                          cycles in proportion to their work.
+     * @param elapsed_       Time spent in run() so far (s).
+     * @param iterationsNum_ Number of iterations of the current cycle.
+     * @return               Time budget of the current cycle (s).
+     */
+    double cycle_time_budget(double elapsed_, int iterationsNum_) const;
+
+    /**
+     * @brief load_records Loads nodes from an array and the edges from the records.
+     * @param coords_             Node coordinates (x0, y0, x1, y1, ...).
+     * @param nodesNum_           Number of nodes.
+     * @param buildCompatibility_ Whether to build the compatibility lists.
+     * @return                    False if an edge refers to an unknown node or no edge is kept.
+     */
+    bool load_records(const double *coords_, uint32_t nodesNum_, bool buildCompatibility_);
+
+    /**
+     * @brief build_edges Creates edges from the records that passed the weight filter.
+     * In percentage mode only the strongest records are selected (by nth_element), so
+     * edges are built for kept records only.
+     * @param records_  Edge records, reordered by decreasing weight.
+     * @param edgesNum_ Number of all edges in the input.
+     * @param maxWidth_ Maximum width (weight + 1) of all edges in the input.
+     */
+    void build_edges(std::vector<EdgeRecord> &records_, int edgesNum_, double maxWidth_);
+
 public:
     /**
      * @brief Graph Constructor.
@@ -53,9 +217,12 @@ public:
 
     /**
      * @brief set_network_params Sets network parameters.
-     * @param weightThreshold_ Threshold of edge weights.
+     * @param edgeWeightThreshold_     Threshold of edge weights.
+     * @param edgePercentageThreshold_ Percentage of strongest edges to keep.
+     * @param mergeEdges_              Whether to merge parallel and anti-parallel edges.
      */
-    void set_network_params(double edgeWeightThreshold_, double edgePercentageThreshold_);
+    void set_network_params(double edgeWeightThreshold_, double edgePercentageThreshold_,
+                            bool mergeEdges_);
 
     /**
      * @brief set_algorithm_params Sets algorithm parameters.
@@ -79,9 +246,94 @@ public:
                             double gravExponent_);
 
     /**
-     * @brief enable_gravitation Sets gravitation on.
+     * @brief enable_gravitation Sets gravitation on or off.
+     * @param enabled_ Whether gravitation is on.
+     */
+    void enable_gravitation(bool enabled_);
+
+    /**
+     * @brief set_checkpoint Sets the checkpoint file. The bundling state is written at
+     *                       the end of each cycle but the last, without stopping the
+     *                       iterations.
+     * @param file_ Name of the checkpoint file, empty to turn checkpoints off.
      */
-    void enable_gravitation();
+    void set_checkpoint(std::string file_);
+
+    /**
+     * @brief resume Continues bundling from a checkpoint: restores the subdivision points,
+     *               the compatibility lists and the cycle state. The network must be read
+     *               with the same filters and the parameters must be the same as when the
+     *               checkpoint was written.
+     * @param file_ Name of the checkpoint file.
+     * @return      False if the file could not be read or belongs to another network.
+     */
+    bool resume(std::string file_);
+
+    /**
+     * @brief warm_start Starts bundling from the result of an earlier run on a similar
+     *                   network instead of straight edges. Edges are matched by the
+     *                   labels of their end points, their subdivision points are
+     *                   resampled from the earlier polylines and new edges start straight.
+     *                   Only the last cycles of the schedule are run.
+     * @param file_   Earlier result in JSON format.
+     * @param cycles_ Number of cycles to run.
+     * @return        False if the file could not be read.
+     */
+    bool warm_start(std::string file_, int cycles_);
+
+    /**
+     * @brief follow Continues from the previous frame of an evolving network: edges that
+     *               are also in the previous frame, in either direction, keep their
+     *               bundled shape and their compatibility, only pairs with new edges are
+     *               tested. Only the last cycles of the schedule are run, and continued
+     *               edges whose compatible edges are the same as before are frozen in
+     *               their previous shape, so that only changed edges are bundled. The
+     *               network must be read from the same nodes file without compatibility
+     *               lists.
+     * @param previous_ Previous frame, bundled with the same parameters but not smoothed.
+     * @param cycles_   Number of cycles to run.
+     * @return          Number of edges continued from the previous frame.
+     */
+    int follow(const Graph &previous_, int cycles_);
+
+    /**
+     * @brief set_time_budget Sets the wall-clock time of bundling. The time left is shared
+     *                        among the cycles by their work, and the iterations of each
+     *                        cycle are cut to fit its share at their measured cost. Once
+     *                        the budget is used up, bundling stops after the current
+     *                        iteration.
+     * @param seconds_ Time budget of run() in seconds, 0 for no limit.
+     */
+    void set_time_budget(double seconds_);
+
+    /**
+     * @brief set_stop_flag Sets a flag that stops bundling after the current iteration
+     *                      when it is set, e.g. from a signal handler. The bundling state
+     *                      is kept, so that the edges can be smoothed and printed.
+     * @param flag_ Stop flag, NULL to ignore stop requests.
+     */
+    void set_stop_flag(const std::atomic<bool> *flag_);
+
+    /**
+     * @brief set_severity_level Sets the lowest severity of the logs of the graph.
+     * @param severityLevel_ Severity level.
+     */
+    void set_severity_level(meerkat::mk_log::SeverityLevel severityLevel_);
+
+    /**
+     * @brief set_memory_limit Sets the memory limit of networks. Networks whose
+     *                         estimated memory exceeds the limit are refused when read.
+     * @param bytes_ Limit in bytes, 0 for no limit.
+     */
+    void set_memory_limit(size_t bytes_);
+
+    /**
+     * @brief memory_estimate Estimates the peak memory of bundling the current network:
+     *                        edges with the subdivision points and forces of the last
+     *                        cycle, compatibility lists and nodes.
+     * @return Estimated memory in bytes.
+     */
+    size_t memory_estimate() const;
 
     /**
      * @brief set_graphics_params Sets graphical parameters fro visualization.
@@ -89,12 +341,70 @@ public:
      */
     void set_graphics_params(double alpha_);
 
+    /**
+     * @brief set_output_params Sets output parameters.
+     * @param compactJson_ Whether JSON is written without whitespace.
+     * @param precision_   Significant digits of coordinates, 0 for the shortest
+     *                     representation that reads back exactly.
+     */
+    void set_output_params(bool compactJson_, int precision_);
+
     /**
      * @brief read Reads in a network (node coordinates and edges).
+     * Both files are memory-mapped and tokenized in a single pass, large files
+     * are split into chunks that are parsed in parallel.
+     * Node labels are interned into dense indices. If the labels are exactly the
+     * integers 0..N-1, they are used as indices directly. Edges with unknown end
+     * points are dropped.
+     * If the nodes file is a binary graph file (see graph_format.hpp), the whole
+     * network is read from it and the edges file is ignored.
+     * @param nodesFile_          Name of the node coordinates file.
+     * @param edgesFile_          Name of the edge endpoints file.
+     * @param buildCompatibility_ Whether to build the compatibility lists, otherwise they
+     *                            must be set by set_compatibility_lists or resume.
+     * @return                    False if the network could not be read or has no edges.
+     */
+    bool read(std::string nodesFile_, std::string edgesFile_, bool buildCompatibility_);
+
+    /**
+     * @brief load Loads a network from arrays, node labels are their indices.
+     * Filters are applied as for files. Storage of a previous network is reused.
+     * @param coords_             Node coordinates (x0, y0, x1, y1, ...).
+     * @param nodesNum_           Number of nodes.
+     * @param edges_              Node indices of the edges (source0, target0, source1, ...).
+     * @param weights_            Edge weights, NULL for edges of weight 1.
+     * @param edgesNum_           Number of edges.
+     * @param buildCompatibility_ Whether to build the compatibility lists, otherwise they
+     *                            must be set by set_compatibility_lists.
+     * @return                    False if an edge refers to an unknown node or no edge is kept.
+     */
+    bool load(const double *coords_, uint32_t nodesNum_,
+              const uint32_t *edges_, const double *weights_, uint32_t edgesNum_,
+              bool buildCompatibility_);
+
+    /**
+     * @brief load Loads a network from arrays of node coordinates and edge records.
+     * Parameters are the same as for the other version.
+     */
+    bool load(const double *coords_, uint32_t nodesNum_,
+              const EdgeRecord *records_, uint32_t edgesNum_,
+              bool buildCompatibility_);
+
+    /**
+     * @brief convert Converts a network from text files into a binary graph file.
      * @param nodesFile_ Name of the node coordinates file.
      * @param edgesFile_ Name of the edge endpoints file.
+     * @param output_    Name of the binary graph file.
+     * @return           False if the network could not be read or written.
+     */
+    bool convert(std::string nodesFile_, std::string edgesFile_, std::string output_);
+
+    /**
+     * @brief node_label Returns the label of a node.
+     * @param node_ Node index.
+     * @return      Label of the node.
      */
-    void read(std::string nodesFile_, std::string edgesFile_);
+    std::string node_label(uint32_t node_) const;
 
     /**
      * @brief get_bounding_box Calculates bounding box of the network.
@@ -111,6 +421,20 @@ public:
      */
     void build_compatibility_lists();
 
+    /**
+     * @brief compatibility_lists Returns the compatibility lists of the edges.
+     * @return Lists, NULL if they are not built.
+     */
+    std::shared_ptr<const CompatibilityLists> compatibility_lists() const;
+
+    /**
+     * @brief set_compatibility_lists Shares the compatibility lists of the edges, built
+     *                                earlier for the same network and parameters.
+     * @param lists_ Compatibility lists.
+     * @return       False if the number of lists differs from the number of edges.
+     */
+    bool set_compatibility_lists(std::shared_ptr<const CompatibilityLists> lists_);
+
     /**
      * @brief iterate Performs a single iteration.
      * @return Number of iterations left.
@@ -124,6 +448,29 @@ public:
      */
     int update_cycle();
 
+    /**
+     * @brief copy_network Copies the network of another graph with its edges in their
+     *                     initial state and shares its compatibility lists, so that the
+     *                     network is bundled with other parameters without reading it
+     *                     again. Subdivisions are reserved for the cycles of this graph.
+     * @param graph_ Graph with a network that is not bundled yet.
+     */
+    void copy_network(const Graph &graph_);
+
+    /**
+     * @brief run Performs all iterations and cycles with subdivisions in between, or
+     *            fewer if the time budget is short or a stop is requested. A stopped run
+     *            writes a checkpoint if checkpoints are on.
+     * Smoothing is left to the caller.
+     */
+    void run();
+
+    /**
+     * @brief reserve_subdivisions Reserves point storage for the final number
+     *                             of subdivisions and the resampling buffers.
+     */
+    void reserve_subdivisions();
+
     /**
      * @brief add_subvisions Adds subdivision points.
      */
@@ -135,21 +482,107 @@ public:
     void smooth();
 
     /**
-     * @brief draw Draws the network.
+     * @brief simplify Simplifies edges with the Douglas-Peucker algorithm.
+     * Edges are processed in parallel, the point reduction is logged.
+     * @param tolerance_ Maximum distance of removed points from the simplified edges.
+     */
+    void simplify(double tolerance_);
+
+    /**
+     * @brief get_polylines Copies the points of the edge polylines (start point,
+     *                      subdivision points and end point) as single precision
+     *                      coordinate pairs, in edge order.
+     * @param points_ Coordinates of the points.
+     * @param counts_ Number of points of each edge.
+     */
+    void get_polylines(std::vector<float> &points_, std::vector<int> &counts_) const;
+
+    /**
+     * @brief nodes Returns the nodes.
+     * @return Nodes of the network.
+     */
+    const std::vector<Node> &nodes() const;
+
+    /**
+     * @brief edges Returns the edges.
+     * @return Edges of the network.
+     */
+    const std::vector<Edge> &edges() const;
+
+    /**
+     * @brief edge_opacity Returns the opacity of edges.
+     * @return Opacity of edges.
      */
-    void draw();
+    double edge_opacity() const;
 
     /**
      * @brief print_json Prints network in JSON format.
+     * Edges are formatted in parallel chunks which are written in order through a
+     * buffered writer.
      * @param output_ Name of output file.
+     * @return        False if the file could not be written.
+     */
+    bool print_json(std::string output_);
+
+    /**
+     * @brief polyline_header Lays out the network in the binary polyline format.
+     * @param header_     Header with the section offsets.
+     * @param scalarSize_ Size of coordinates in bytes (4 or 8).
+     * @return            Total size of the binary polyline data in bytes.
+     */
+    size_t polyline_header(PolylineFileHeader &header_, int scalarSize_) const;
+
+    /**
+     * @brief fill_polylines Writes the network in the binary polyline format.
+     * Edges are written in parallel.
+     * @param buffer_ Destination of the size returned by polyline_header.
+     * @param header_ Header returned by polyline_header.
+     */
+    void fill_polylines(char *buffer_, const PolylineFileHeader &header_) const;
+
+    /**
+     * @brief print_binary Prints network in the binary polyline format (see
+     *                     polyline_format.hpp) through a memory-mapped file.
+     * @param output_     Name of output file.
+     * @param scalarSize_ Size of coordinates in bytes (4 or 8).
+     * @return            False if the file could not be written.
      */
-    void print_json(std::string output_);
+    bool print_binary(std::string output_, int scalarSize_);
 
     /**
      * @brief print_svg Prints network in SVG format.
+     * Every edge is a path with its width and the edge opacity, streamed through
+     * a fixed size buffer. Coordinates are written with the output precision.
      * @param output_ Name of output file.
+     * @return        False if the file could not be written.
+     */
+    bool print_svg(std::string output_);
+
+    /**
+     * @brief print_image Renders the network without a display and prints it in PNG
+     *                    format, or in PPM/PGM format if the file name ends with .ppm/.pgm.
+     *                    PGM files always hold the density map, PPM files cannot.
+     * Tiles of the image are rendered in parallel by the software rasterizer.
+     * @param output_  Name of output file.
+     * @param size_    Size of the longer side of the image in pixels.
+     * @param density_ If true, a gray edge density map is rendered instead of edges and nodes.
+     * @return         False if the file could not be written.
+     */
+    bool print_image(std::string output_, int size_, bool density_);
+
+    /**
+     * @brief print_tiles Prints an XYZ pyramid of edge density tiles.
+     * The square of the bounding box is split into 2^z x 2^z tiles of TILE_SIZE pixels at
+     * zoom level z, which are written as directory_/z/x/y.png (y = 0 is the top row).
+     * Tiles are transparent PNG images with the edge color, their opacity is the
+     * accumulated opacity of the edges. Segments are binned into the tiles of each level in
+     * bands of rows (see TILE_BAND_PAIRS), only the tiles they overlap are rendered, in
+     * parallel, and empty tiles are skipped.
+     * @param directory_ Root directory of the pyramid.
+     * @param maxZoom_   Largest zoom level.
+     * @return           False if the zoom level is invalid or a tile could not be written.
      */
-    void print_svg(std::string output_);
+    bool print_tiles(std::string directory_, int maxZoom_);
 };
 
 #endif // GRAPH_HPP
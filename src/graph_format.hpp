@@ -0,0 +1,40 @@
+#ifndef GRAPH_FORMAT_HPP
+#define GRAPH_FORMAT_HPP
+
+#include <stdint.h>
+
+// Binary graph file layout (native byte order, all sections 8-byte aligned):
+//   GraphFileHeader
+//   double      coordinates[2*nodesNum]        x0 y0 x1 y1 ...
+//   EdgeRecord  edges[edgesNum]
+//   uint64_t    labelOffsets[nodesNum+1]       only if GRAPH_FILE_HAS_LABELS is set
+//   char        labels[labelsSize]             concatenated labels, not terminated
+// Without a label table nodes are labelled by their index.
+
+#define GRAPH_FILE_MAGIC "FDEBGRPH"
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FILE_BYTE_ORDER 0x01020304u
+#define GRAPH_FILE_HAS_LABELS 0x1u
+
+// Header of the binary graph file
+struct GraphFileHeader
+{
+    char magic[8];              // GRAPH_FILE_MAGIC without terminating zero.
+    uint32_t version;           // GRAPH_FILE_VERSION.
+    uint32_t byteOrder;         // GRAPH_FILE_BYTE_ORDER as written by the producer.
+    uint32_t flags;             // Combination of GRAPH_FILE_* flags.
+    uint32_t reserved;          // Padding, zero.
+    uint64_t nodesNum;          // Number of nodes.
+    uint64_t edgesNum;          // Number of edges.
+    uint64_t labelsSize;        // Total length of the labels in bytes.
+};
+
+// Edge as stored in the binary graph file, also used as lightweight edge record while loading
+struct EdgeRecord
+{
+    uint32_t source;            // Index of source node.
+    uint32_t target;            // Index of target node.
+    double weight;              // Raw edge weight.
+};
+
+#endif // GRAPH_FORMAT_HPP
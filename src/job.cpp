@@ -0,0 +1,243 @@
+#include "job.hpp"
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief parse_double Parses a whole string as a floating point number.
+ * @param value_  String.
+ * @param result_ Parsed number.
+ * @return        False if the string is not a number.
+ */
+static bool parse_double(const std::string &value_, double &result_)
+{
+    char *end = NULL;
+    result_ = strtod(value_.c_str(), &end);
+    return !value_.empty() && *end == '\0';
+}
+
+/**
+ * @brief parse_int Parses a whole string as an integer.
+ * @param value_  String.
+ * @param result_ Parsed number.
+ * @return        False if the string is not an integer.
+ */
+static bool parse_int(const std::string &value_, int &result_)
+{
+    char *end = NULL;
+    result_ = (int)strtol(value_.c_str(), &end, 10);
+    return !value_.empty() && *end == '\0';
+}
+
+/**
+ * @brief parse_flag Parses a flag given as 0 or 1.
+ * @param value_  String.
+ * @param result_ Parsed flag.
+ * @return        False if the string is neither 0 nor 1.
+ */
+static bool parse_flag(const std::string &value_, bool &result_)
+{
+    result_ = value_ == "1";
+    return value_ == "0" || value_ == "1";
+}
+
+/**
+ * @brief ends_with Checks the extension of a file name.
+ * @param name_      File name.
+ * @param extension_ Extension with the dot.
+ * @return           True if the name ends with the extension.
+ */
+static bool ends_with(const std::string &name_, const char *extension_)
+{
+    size_t length = strlen(extension_);
+    return name_.size() >= length && name_.compare(name_.size()-length, length, extension_) == 0;
+}
+
+Job::Job()
+{
+    K = 0.1;
+    cycles = 5;
+    I = 90;
+    compat = 0.6;
+    sigma = 3.0;
+    S = 0.4;
+    epsilon = 0.0001;
+    gravitation = false;
+    gravitationCenter.set(0.0, 0.0);
+    gravitationExponent = 1.0;
+    edgeWeight = -1.0;
+    edgePercentage = -1.0;
+    mergeEdges = false;
+    transparency = 0.3;
+    compactJson = false;
+    precision = 6;
+    simplifyTolerance = -1.0;
+    binaryScalarSize = 4;
+    imageSize = DEFAULT_SIZE;
+    imageDensity = false;
+    tileZoom = 4;
+    resume = false;
+    warmCycles = 2;
+    timeBudget = 0.0;
+}
+
+bool Job::set(const std::string &key_, const std::string &value_)
+{
+    double x = 0.0;
+    bool flag = false;
+    if( key_ == "K" )
+        return parse_double(value_, K);
+    if( key_ == "cycles" )
+        return parse_int(value_, cycles) && cycles > 0 && cycles <= MAX_CYCLES;
+    if( key_ == "I" )
+        return parse_int(value_, I) && I >= 0;
+    if( key_ == "compat" )
+        return parse_double(value_, compat);
+    if( key_ == "sigma" )
+        return parse_double(value_, sigma);
+    if( key_ == "S" )
+        return parse_double(value_, S);
+    if( key_ == "epsilon" )
+        return parse_double(value_, epsilon);
+    if( key_ == "gravitation-center-x" || key_ == "gravitation-center-y" )
+    {
+        if( !parse_double(value_, x) )
+            return false;
+        if( key_ == "gravitation-center-x" )
+            gravitationCenter.set_x(x);
+        else
+            gravitationCenter.set_y(x);
+        gravitation = true;
+        return true;
+    }
+    if( key_ == "gravitation-exponent" )
+        return (gravitation = parse_double(value_, gravitationExponent));
+    if( key_ == "edge-weight" )
+        return parse_double(value_, edgeWeight);
+    if( key_ == "edge-percentage" )
+        return parse_double(value_, edgePercentage);
+    if( key_ == "merge-edges" )
+        return parse_flag(value_, mergeEdges);
+    if( key_ == "transparency" )
+        return parse_double(value_, transparency);
+    if( key_ == "json-compact" )
+        return parse_flag(value_, compactJson);
+    if( key_ == "precision" )
+        return parse_int(value_, precision);
+    if( key_ == "simplify" )
+        return parse_double(value_, simplifyTolerance);
+    if( key_ == "binary-float64" )
+    {
+        if( !parse_flag(value_, flag) )
+            return false;
+        binaryScalarSize = flag ? 8 : 4;
+        return true;
+    }
+    if( key_ == "image-size" )
+        return parse_int(value_, imageSize) && imageSize > 0;
+    if( key_ == "image-density" )
+        return parse_flag(value_, imageDensity);
+    if( key_ == "tile-zoom" )
+        return parse_int(value_, tileZoom) && tileZoom >= 0 && tileZoom <= TILE_MAX_ZOOM;
+    if( key_ == "resume" )
+        return parse_flag(value_, resume);
+    if( key_ == "warm-cycles" )
+        return parse_int(value_, warmCycles) && warmCycles > 0;
+    if( key_ == "time-budget" )
+        return parse_double(value_, timeBudget) && timeBudget >= 0.0;
+    if( key_ == "json" )
+        json = value_;
+    else if( key_ == "binary" )
+        binary = value_;
+    else if( key_ == "svg" )
+        svg = value_;
+    else if( key_ == "image" )
+        image = value_;
+    else if( key_ == "tiles" )
+        tiles = value_;
+    else if( key_ == "checkpoint" )
+        checkpoint = value_;
+    else if( key_ == "warm-start" )
+        warmStart = value_;
+    else
+        return false;
+    return true;
+}
+
+bool Job::set_params(std::istream &params_, std::string &invalid_)
+{
+    std::string param;
+    while( params_ >> param )
+    {
+        size_t separator = param.find('=');
+        if( separator == std::string::npos
+                || !set(param.substr(0, separator), param.substr(separator+1)) )
+        {
+            invalid_ = param;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Job::set_output(const std::string &output_)
+{
+    if( ends_with(output_, ".bin") )
+        binary = output_;
+    else if( ends_with(output_, ".svg") )
+        svg = output_;
+    else if( ends_with(output_, ".png") || ends_with(output_, ".ppm") || ends_with(output_, ".pgm") )
+        image = output_;
+    else
+        json = output_;
+}
+
+void Job::configure(Graph &graph_) const
+{
+    graph_.set_algorithm_params(K, cycles, I, compat, sigma);
+    graph_.set_network_params(edgeWeight, edgePercentage, mergeEdges);
+    graph_.set_physics_params(S, epsilon, gravitationCenter, gravitationExponent);
+    graph_.enable_gravitation(gravitation);
+    graph_.set_output_params(compactJson, precision);
+    graph_.set_graphics_params(transparency);
+    graph_.set_checkpoint(checkpoint);
+    graph_.set_time_budget(timeBudget);
+}
+
+bool Job::read(Graph &graph_) const
+{
+    // compatibility lists are restored from the checkpoint
+    bool resuming = resume && checkpoint != "" && access(checkpoint.c_str(), F_OK) == 0;
+    if( !graph_.read(nodes, edges, !resuming) )
+        return false;
+    if( resuming )
+        return graph_.resume(checkpoint);
+    return warmStart == "" || graph_.warm_start(warmStart, warmCycles);
+}
+
+bool Job::finish(Graph &graph_) const
+{
+    graph_.smooth();
+    if( simplifyTolerance > 0.0 )
+        graph_.simplify(simplifyTolerance);
+    bool ok = true;
+    if( json != "" )
+        ok = graph_.print_json(json) && ok;
+    if( binary != "" )
+        ok = graph_.print_binary(binary, binaryScalarSize) && ok;
+    if( svg != "" )
+        ok = graph_.print_svg(svg) && ok;
+    if( image != "" )
+        ok = graph_.print_image(image, imageSize, imageDensity) && ok;
+    if( tiles != "" )
+        ok = graph_.print_tiles(tiles, tileZoom) && ok;
+    return ok;
+}
+
+std::string Job::output_name(const std::string &output_, const std::string &suffix_)
+{
+    size_t dot = output_.find_last_of('.');
+    size_t slash = output_.find_last_of('/');
+    if( dot == std::string::npos || (slash != std::string::npos && dot < slash) )
+        dot = output_.size();
+    return output_.substr(0, dot) + suffix_ + output_.substr(dot);
+}
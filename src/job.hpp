@@ -0,0 +1,127 @@
+#ifndef JOB_HPP
+#define JOB_HPP
+
+#include <string>
+#include <istream>
+#include "meerkat_vector2.hpp"
+#include "graph.hpp"
+
+#define DEFAULT_SIZE 600                // Default size of the longer side of images in pixels.
+
+// Job struct
+// Input files, parameters and outputs of bundling a single network. Defaults are the
+// defaults of the command line.
+struct Job
+{
+    // Input
+    std::string nodes;                  // Node coordinates or binary graph file.
+    std::string edges;                  // Edges file, unused for binary graph files.
+
+    // Algorithm parameters
+    double K;
+    int cycles;
+    int I;
+    double compat;
+    double sigma;
+
+    // Physical parameters
+    double S;
+    double epsilon;
+    bool gravitation;
+    meerkat::mk_vector2 gravitationCenter;
+    double gravitationExponent;
+
+    // Network parameters
+    double edgeWeight;
+    double edgePercentage;
+    bool mergeEdges;
+
+    // Graphics and output parameters
+    double transparency;
+    bool compactJson;
+    int precision;
+    double simplifyTolerance;           // Not positive if edges are not simplified.
+
+    // Outputs, empty names are not written
+    std::string json;
+    std::string binary;
+    int binaryScalarSize;
+    std::string svg;
+    std::string image;
+    int imageSize;
+    bool imageDensity;
+    std::string tiles;
+    int tileZoom;
+
+    // Checkpoints
+    std::string checkpoint;             // Checkpoint file, empty if off.
+    bool resume;                        // Continue from the checkpoint file if it exists.
+
+    // Warm start
+    std::string warmStart;              // Earlier result to start from, empty if off.
+    int warmCycles;                     // Number of cycles run after a warm start.
+
+    // Anytime mode
+    double timeBudget;                  // Wall-clock time of bundling in seconds, 0 if unlimited.
+
+    Job();
+
+    /**
+     * @brief set Sets a parameter or an output by the long name of its command line
+     *            option (without dashes). Flags take 0 or 1, setting any gravitation
+     *            parameter turns gravitation on.
+     * @param key_   Option name.
+     * @param value_ Value.
+     * @return       False if the option is unknown or the value is invalid.
+     */
+    bool set(const std::string &key_, const std::string &value_);
+
+    /**
+     * @brief set_params Sets parameters given as whitespace separated key=value pairs
+     *                   (see set).
+     * @param params_  Stream of pairs, read until its end.
+     * @param invalid_ First pair that could not be set.
+     * @return         False if a pair is malformed or could not be set.
+     */
+    bool set_params(std::istream &params_, std::string &invalid_);
+
+    /**
+     * @brief set_output Sets the output by the extension of a file name: .bin for the
+     *                   binary format, .svg for SVG, .png/.ppm/.pgm for images and JSON
+     *                   otherwise.
+     * @param output_ Name of output file.
+     */
+    void set_output(const std::string &output_);
+
+    /**
+     * @brief output_name Inserts a suffix into a file name before its extension.
+     * @param output_ Name of output file.
+     * @param suffix_ Suffix, e.g. the index of a frame.
+     * @return        Name with the suffix.
+     */
+    static std::string output_name(const std::string &output_, const std::string &suffix_);
+
+    /**
+     * @brief configure Sets the parameters of a graph.
+     * @param graph_ Graph to configure.
+     */
+    void configure(Graph &graph_) const;
+
+    /**
+     * @brief read Reads the network into a graph, and continues from the checkpoint
+     *             if resuming and the checkpoint file exists, or else from the earlier
+     *             result if warm starting.
+     * @param graph_ Configured graph.
+     * @return       False if the network or the checkpoint could not be read.
+     */
+    bool read(Graph &graph_) const;
+
+    /**
+     * @brief finish Smooths and simplifies the bundled edges and prints all outputs.
+     * @param graph_ Bundled graph.
+     * @return       False if an output could not be written.
+     */
+    bool finish(Graph &graph_) const;
+};
+
+#endif // JOB_HPP
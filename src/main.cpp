@@ -1,80 +1,259 @@
 #include "stdlib.h"
+#include <signal.h>
+#include <sstream>
+#include <atomic>
 #include "graph.hpp"
-#include "GLUT/glut.h"
+#include "job.hpp"
+#include "server.hpp"
+#include "batch.hpp"
+#include "sweep.hpp"
+#include "animation.hpp"
 #include "meerkat_argument_manager.hpp"
 #include "meerkat_vector2.hpp"
+#ifdef FDEB_WITH_GL
+#include "viewer.hpp"
+#endif
 
-#define DEFAULT_SIZE 600
+// Set by SIGINT and SIGTERM, bundling stops after the current iteration and the result
+// is written.
+static std::atomic<bool> stopRequested(false);
 
-Graph gGraph;
-std::string gJson = "";
+void request_stop( int signal_ )
+{
+    stopRequested = true;
+    // a second signal terminates at once
+    signal(signal_, SIG_DFL);
+}
 
-void init( meerkat::mk_vector2 bottomLeft_,
-           meerkat::mk_vector2 topRight_ )
+int convert( int argc_, char **argv_ )
 {
-    glClearColor( 1.0, 1.0, 1.0, 1.0 );
-    glMatrixMode( GL_PROJECTION );
-    glLoadIdentity();
-    gluOrtho2D( bottomLeft_.x(), topRight_.x(), bottomLeft_.y(), topRight_.y() );
-    glMatrixMode( GL_MODELVIEW );
-    glLoadIdentity();
-
-    glEnable( GL_LINE_SMOOTH );
-    glHint (GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable( GL_BLEND );
+    meerkat::mk_argument_manager a("Converts a network into the binary graph format",
+                                   "Usage: fdeb convert [options]");
+    a.add_help();
+    a.add_argument_entry( "nodes", MK_VALUE, "--nodes", "-n",
+                          "File containing node positions", "", MK_REQUIRED);
+    a.add_argument_entry( "edges", MK_VALUE, "--edges", "-e",
+                          "File containing edges", "", MK_REQUIRED);
+    a.add_argument_entry( "output", MK_VALUE, "--output", "-o",
+                          "Binary graph file to write", "", MK_REQUIRED);
+    a.read_arguments(argc_, argv_);
+    a.show_settings();
+
+    Graph graph;
+    if( !graph.convert(a.get_string_argument("nodes"),
+                       a.get_string_argument("edges"),
+                       a.get_string_argument("output")) )
+        return 1;
+    return 0;
+}
+
+int serve( int argc_, char **argv_ )
+{
+    meerkat::mk_argument_manager a("Bundles networks sent over a Unix domain socket",
+                                   "Usage: fdeb serve [options]");
+    a.add_help();
+    a.add_argument_entry( "socket", MK_VALUE, "--socket", "-s",
+                          "Path of the Unix domain socket. Messages are described in "
+                          "serve_format.hpp", "", MK_REQUIRED);
+    a.add_argument_entry( "workers", MK_VALUE, "--workers", "-w",
+                          "Number of jobs bundled at the same time [1]", "1", MK_OPTIONAL);
+    a.read_arguments(argc_, argv_);
+    a.show_settings();
+
+    Server server(a.get_string_argument("socket"), a.get_int_argument("workers"));
+    // the server returns only if it could not start
+    return server.run() ? 0 : 1;
 }
 
-void display()
+int batch( int argc_, char **argv_ )
 {
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-    gGraph.draw();
-    glutSwapBuffers();
-    glFlush();
+    meerkat::mk_argument_manager a("Bundles the networks listed in a manifest concurrently",
+                                   "Usage: fdeb batch [options]");
+    a.add_help();
+    a.add_argument_entry( "manifest", MK_VALUE, "--manifest", "-M",
+                          "Manifest file with one job per line: nodes edges output "
+                          "[key=value ...]. Use '-' as edges for binary graph files, the "
+                          "output format is chosen by extension (.json, .bin, .svg, "
+                          ".png/.ppm/.pgm) and keys are long option names without dashes",
+                          "", MK_REQUIRED);
+    a.add_argument_entry( "workers", MK_VALUE, "--workers", "-w",
+                          "Number of jobs bundled at the same time [one per core]", "0", MK_OPTIONAL);
+    a.add_argument_entry( "memory limit", MK_VALUE, "--memory-limit", "-ml",
+                          "Estimated memory limit of a job in MB, larger networks are "
+                          "refused [unset]", "0", MK_OPTIONAL);
+    a.add_argument_entry( "summary", MK_VALUE, "--summary", "-sm",
+                          "Prints the outcome and timings of jobs as tab separated values "
+                          "in the given file [standard output]", "", MK_OPTIONAL);
+    a.read_arguments(argc_, argv_);
+    a.show_settings();
+
+    Batch batch(a.get_int_argument("workers"), a.get_double_argument("memory limit"));
+    if( !batch.read_manifest(a.get_string_argument("manifest")) )
+        return 1;
+    int failedNum = batch.run();
+    if( !batch.print_summary(a.get_string_argument("summary")) || failedNum > 0 )
+        return 1;
+    return 0;
 }
 
-void keyboard( unsigned char key_, int x_, int y_ )
+int sweep( int argc_, char **argv_ )
 {
-    switch( key_ )
+    meerkat::mk_argument_manager a("Bundles a network with every combination of parameter grids",
+                                   "Usage: fdeb sweep [options]");
+    a.add_help();
+    a.add_argument_entry( "nodes", MK_VALUE, "--nodes", "-n",
+                          "File containing node positions or a binary graph file", "", MK_REQUIRED);
+    a.add_argument_entry( "edges", MK_VALUE, "--edges", "-e",
+                          "File containing edges, not needed for binary graph files", "", MK_OPTIONAL);
+    a.add_argument_entry( "output", MK_VALUE, "--output", "-o",
+                          "Base output name, swept values are inserted before the extension "
+                          "that chooses the format (.json, .bin, .svg, .png/.ppm/.pgm)",
+                          "", MK_REQUIRED);
+    a.add_argument_entry( "K", MK_VALUE, "--K", "-K",
+                          "Comma separated values of the edge stiffness [0.1]", "", MK_OPTIONAL);
+    a.add_argument_entry( "S", MK_VALUE, "--S", "-S",
+                          "Comma separated initial values of S [0.4]", "", MK_OPTIONAL);
+    a.add_argument_entry( "I", MK_VALUE, "--I", "-i",
+                          "Comma separated initial numbers of iterations [90]", "", MK_OPTIONAL);
+    a.add_argument_entry( "cycles", MK_VALUE, "--cycles", "-C",
+                          "Comma separated numbers of cycles [5]", "", MK_OPTIONAL);
+    a.add_argument_entry( "sigma", MK_VALUE, "--sigma", "-s",
+                          "Comma separated smoothing widths [3]", "", MK_OPTIONAL);
+    a.add_argument_entry( "params", MK_VALUE, "--params", "-P",
+                          "Space separated key=value pairs of fixed parameters, keys are "
+                          "long option names without dashes [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "workers", MK_VALUE, "--workers", "-w",
+                          "Number of configurations bundled at the same time [one per core]",
+                          "0", MK_OPTIONAL);
+    a.add_argument_entry( "summary", MK_VALUE, "--summary", "-sm",
+                          "Prints the swept values and timings as tab separated values in "
+                          "the given file [standard output]", "", MK_OPTIONAL);
+    a.read_arguments(argc_, argv_);
+    a.show_settings();
+
+    Job base;
+    base.nodes = a.get_string_argument("nodes");
+    base.edges = a.get_string_argument("edges");
+    std::istringstream params(a.get_string_argument("params"));
+    std::string invalid;
+    if( !base.set_params(params, invalid) )
     {
-    case 27:
-        exit(0);
-        break;
+        meerkat::mk_log("fdeb").e("sweep", "invalid parameter '%s'", invalid.c_str());
+        return 1;
     }
+
+    Sweep sweep(base, a.get_string_argument("output"), a.get_int_argument("workers"));
+    const char *grids[] = {"K", "S", "I", "cycles", "sigma"};
+    for( int g=0; g<5; g++ )
+    {
+        if( a.is_set(grids[g]) && !sweep.add_grid(grids[g], a.get_string_argument(grids[g])) )
+            return 1;
+    }
+    int failedNum = sweep.run();
+    if( failedNum < 0 )
+        return 1;
+    if( !sweep.print_summary(a.get_string_argument("summary")) || failedNum > 0 )
+        return 1;
+    return 0;
 }
 
-void timer( int var_ )
+int animate( int argc_, char **argv_ )
 {
-    if( gGraph.iterate() > 0 )
-        glutTimerFunc( 10, timer, var_ );
-    else
+    meerkat::mk_argument_manager a("Bundles the frames of an evolving network, each continuing "
+                                   "from the previous one with unchanged edges frozen",
+                                   "Usage: fdeb animate [options]");
+    a.add_help();
+    a.add_argument_entry( "nodes", MK_VALUE, "--nodes", "-n",
+                          "File containing node positions of all frames", "", MK_REQUIRED);
+    a.add_argument_entry( "frames", MK_VALUE, "--frames", "-F",
+                          "File listing the edges file of one frame per line", "", MK_REQUIRED);
+    a.add_argument_entry( "output", MK_VALUE, "--output", "-o",
+                          "Base output name, frame indices are inserted before the extension "
+                          "that chooses the format (.json, .bin, .svg, .png/.ppm/.pgm)",
+                          "", MK_REQUIRED);
+    a.add_argument_entry( "params", MK_VALUE, "--params", "-P",
+                          "Space separated key=value pairs of parameters, keys are long option "
+                          "names without dashes. warm-cycles sets the number of cycles of "
+                          "frames after the first [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "summary", MK_VALUE, "--summary", "-sm",
+                          "Prints the outcome and timings of frames as tab separated values "
+                          "in the given file [standard output]", "", MK_OPTIONAL);
+    a.read_arguments(argc_, argv_);
+    a.show_settings();
+
+    Job base;
+    base.nodes = a.get_string_argument("nodes");
+    std::istringstream params(a.get_string_argument("params"));
+    std::string invalid;
+    if( !base.set_params(params, invalid) )
     {
-        if( gGraph.update_cycle() > 0 )
-        {
-            gGraph.add_subvisions();
-            glutTimerFunc( 10, timer, var_ );
-        }
-        else
-        {
-            gGraph.smooth();
-            if( gJson != "" )
-                gGraph.print_json(gJson);
-        }
+        meerkat::mk_log("fdeb").e("animate", "invalid parameter '%s'", invalid.c_str());
+        return 1;
     }
-    display();
+
+    Animation animation(base, a.get_string_argument("output"));
+    if( !animation.read_frames(a.get_string_argument("frames")) )
+        return 1;
+    int failedNum = animation.run();
+    if( !animation.print_summary(a.get_string_argument("summary")) || failedNum > 0 )
+        return 1;
+    return 0;
 }
 
 int main( int argc_, char **argv_ )
 {
+    if( argc_ > 1 && strcmp(argv_[1], "convert") == 0 )
+        return convert( argc_-1, argv_+1 );
+    if( argc_ > 1 && strcmp(argv_[1], "serve") == 0 )
+        return serve( argc_-1, argv_+1 );
+    if( argc_ > 1 && strcmp(argv_[1], "batch") == 0 )
+        return batch( argc_-1, argv_+1 );
+    if( argc_ > 1 && strcmp(argv_[1], "sweep") == 0 )
+        return sweep( argc_-1, argv_+1 );
+    if( argc_ > 1 && strcmp(argv_[1], "animate") == 0 )
+        return animate( argc_-1, argv_+1 );
+
     meerkat::mk_argument_manager a("Force-directed edge bundling calculator",
                                    "Usage: fdeb [options]");
     a.add_help();
     a.add_argument_entry( "nodes", MK_VALUE, "--nodes", "-n",
-                          "File containing node positions", "", MK_REQUIRED);
+                          "File containing node positions or a binary graph file "
+                          "created by 'fdeb convert'", "", MK_REQUIRED);
     a.add_argument_entry( "edges", MK_VALUE, "--edges", "-e",
-                          "File containing edges", "", MK_REQUIRED);
+                          "File containing edges, not needed for binary graph files", "", MK_OPTIONAL);
     a.add_argument_entry( "json", MK_VALUE, "--json", "-json",
                           "Prints result in a JSON file [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "compact json", MK_FLAG, "--json-compact", "-jc",
+                          "Writes JSON without indentation [off]", "0", MK_OPTIONAL);
+    a.add_argument_entry( "precision", MK_VALUE, "--precision", "-p",
+                          "Significant digits of output coordinates [6]. "
+                          "0 writes the shortest representation that reads back exactly",
+                          "6", MK_OPTIONAL);
+    a.add_argument_entry( "binary", MK_VALUE, "--binary", "-b",
+                          "Prints node positions and edge polylines in a binary file [unset]. "
+                          "The layout is described in polyline_format.hpp", "", MK_OPTIONAL);
+    a.add_argument_entry( "binary float64", MK_FLAG, "--binary-float64", "-b64",
+                          "Writes 64-bit coordinates in the binary file instead of 32-bit [off]",
+                          "0", MK_OPTIONAL);
+    a.add_argument_entry( "svg", MK_VALUE, "--svg", "-svg",
+                          "Prints result in an SVG file [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "image", MK_VALUE, "--image", "-img",
+                          "Renders result without a display in a PNG file, or in a PPM/PGM "
+                          "file if the name ends with .ppm/.pgm [unset]. PGM files hold the "
+                          "density map", "", MK_OPTIONAL);
+    a.add_argument_entry( "image size", MK_VALUE, "--image-size", "-is",
+                          "Size of the longer side of the image in pixels [600]", "600", MK_OPTIONAL);
+    a.add_argument_entry( "image density", MK_FLAG, "--image-density", "-id",
+                          "Renders a gray edge density map instead of edges and nodes [off]",
+                          "0", MK_OPTIONAL);
+    a.add_argument_entry( "tiles", MK_VALUE, "--tiles", "-tl",
+                          "Prints an XYZ pyramid of edge density PNG tiles in the given "
+                          "directory [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "tile zoom", MK_VALUE, "--tile-zoom", "-tz",
+                          "Largest zoom level of the tile pyramid [4]", "4", MK_OPTIONAL);
+    a.add_argument_entry( "simplify", MK_VALUE, "--simplify", "-sp",
+                          "Simplifies edges after smoothing with the given tolerance in output "
+                          "units using the Douglas-Peucker algorithm [unset]", "-1.0", MK_OPTIONAL);
     a.add_argument_entry( "K", MK_VALUE, "--K", "-K",
                           "Edge stiffness [0.1]", "0.1", MK_OPTIONAL);
     a.add_argument_entry( "S", MK_VALUE, "--S", "-S",
@@ -95,6 +274,10 @@ int main( int argc_, char **argv_ )
                           "Edge percentage for edge filtering [unset]."
                           "The given fraction of edges among the strongest ones are kept",
                           "-1.0", MK_OPTIONAL);
+    a.add_argument_entry( "merge edges", MK_FLAG, "--merge-edges", "-m",
+                          "Merges parallel and anti-parallel edges summing their weights [off]. "
+                          "Weight filters apply to the merged weights",
+                          "0", MK_OPTIONAL);
     a.add_argument_entry( "epsilon", MK_VALUE, "--epsilon", "-E",
                           "Lowest interaction distance [1e-4]", "0.0001", MK_OPTIONAL);
     a.add_argument_entry( "gravitation center x", MK_VALUE, "--gravitation-center-x", "-gcx",
@@ -106,82 +289,117 @@ int main( int argc_, char **argv_ )
     a.add_argument_entry( "gravitation exponent", MK_VALUE, "--gravitation-exponent", "-ge",
                           "Gravitation exponent [-2.0]. If set, gravitation is turned on",
                           "1.0", MK_OPTIONAL);
+    a.add_argument_entry( "checkpoint", MK_VALUE, "--checkpoint", "-ck",
+                          "Writes the bundling state in the given file at the end of each "
+                          "cycle [unset]", "", MK_OPTIONAL);
+    a.add_argument_entry( "resume", MK_FLAG, "--resume", "-r",
+                          "Continues from the checkpoint file if it exists [off]. "
+                          "Input and parameters must be the same as when it was written",
+                          "0", MK_OPTIONAL);
+    a.add_argument_entry( "warm start", MK_VALUE, "--warm-start", "-ws",
+                          "Starts from an earlier JSON result of a similar network [unset]. "
+                          "Edges are matched by their end point labels, new edges start straight",
+                          "", MK_OPTIONAL);
+    a.add_argument_entry( "warm cycles", MK_VALUE, "--warm-cycles", "-wc",
+                          "Number of cycles run at the end of the schedule after a warm start [2]",
+                          "2", MK_OPTIONAL);
+    a.add_argument_entry( "time budget", MK_VALUE, "--time-budget", "-tb",
+                          "Wall-clock time of reading and bundling in seconds, iterations "
+                          "are cut to fit and bundling stops when the time is up [unset]. "
+                          "Smoothing and writing follow",
+                          "0", MK_OPTIONAL);
+#ifdef FDEB_WITH_GL
     a.add_argument_entry( "visualization", MK_FLAG, "--visualize", "-v",
                           "Enables real-time visualization [off]", "0", MK_OPTIONAL);
+#endif
     a.add_argument_entry( "transparency", MK_VALUE, "--transparency", "-t",
                           "Transparency of edges", "0.3", MK_OPTIONAL);
     a.read_arguments(argc_, argv_);
     a.show_settings();
 
     // set params and read graph
-    gGraph.set_algorithm_params( a.get_double_argument("K"),
-                                 a.get_int_argument("cycles"),
-                                 a.get_int_argument("I"),
-                                 a.get_double_argument("compat"),
-                                 a.get_double_argument("sigma"));
-    gGraph.set_network_params( a.get_double_argument("edge weight"),
-                               a.get_double_argument("edge percentage") );
-    gGraph.set_physics_params( a.get_double_argument("S"),
-                               a.get_double_argument("epsilon"),
-                               meerkat::mk_vector2(a.get_double_argument("gravitation center x"),
-                                                   a.get_double_argument("gravitation center y")),
-                               a.get_double_argument("gravitation exponent") );
-    if( a.is_set("gravitation center x") ||
+    meerkat::mk_stopwatch stopwatch;
+    Job job;
+    job.K = a.get_double_argument("K");
+    if( !job.set("cycles", a.get_string_argument("cycles")) || !job.set("I", a.get_string_argument("I")) )
+    {
+        meerkat::mk_log("fdeb").e("main", "cycles must be between 1 and %d and I must not be negative",
+                                  MAX_CYCLES);
+        return 1;
+    }
+    if( !job.set("tile-zoom", a.get_string_argument("tile zoom")) )
+    {
+        meerkat::mk_log("fdeb").e("main", "tile zoom must be between 0 and %d", TILE_MAX_ZOOM);
+        return 1;
+    }
+    job.compat = a.get_double_argument("compat");
+    job.sigma = a.get_double_argument("sigma");
+    job.edgeWeight = a.get_double_argument("edge weight");
+    job.edgePercentage = a.get_double_argument("edge percentage");
+    job.mergeEdges = a.is_set("merge edges");
+    job.S = a.get_double_argument("S");
+    job.epsilon = a.get_double_argument("epsilon");
+    job.gravitationCenter.set(a.get_double_argument("gravitation center x"),
+                              a.get_double_argument("gravitation center y"));
+    job.gravitationExponent = a.get_double_argument("gravitation exponent");
+    job.gravitation = a.is_set("gravitation center x") ||
             a.is_set("gravitation center y") ||
-            a.is_set("gravitation exponent") )
-        gGraph.enable_gravitation();
+            a.is_set("gravitation exponent");
+    job.compactJson = a.is_set("compact json");
+    job.precision = a.get_int_argument("precision");
+    job.transparency = a.get_double_argument("transparency");
 
     // Read graph
-    gGraph.read(a.get_string_argument("nodes"),
-                a.get_string_argument("edges"));
+    job.nodes = a.get_string_argument("nodes");
+    job.edges = a.get_string_argument("edges");
+    if( a.is_set("checkpoint") )
+        job.checkpoint = a.get_string_argument("checkpoint");
+    job.resume = a.is_set("resume");
+    if( a.is_set("warm start") )
+        job.warmStart = a.get_string_argument("warm start");
+    job.warmCycles = a.get_int_argument("warm cycles");
+    job.timeBudget = std::max(0.0, a.get_double_argument("time budget"));
+    Graph graph;
+    job.configure(graph);
+    if( !job.read(graph) )
+        return 1;
+
+    // reading counts against the time budget
+    if( job.timeBudget > 0.0 )
+    {
+        graph.set_time_budget(std::max(1e-3, job.timeBudget - stopwatch.seconds()));
+    }
 
     // Get output name
     if( a.is_set("json") )
-        gJson = a.get_string_argument("json");
+        job.json = a.get_string_argument("json");
+    job.simplifyTolerance = a.get_double_argument("simplify");
+    if( a.is_set("svg") )
+        job.svg = a.get_string_argument("svg");
+    if( a.is_set("image") )
+        job.image = a.get_string_argument("image");
+    job.imageSize = a.get_int_argument("image size");
+    job.imageDensity = a.is_set("image density");
+    if( a.is_set("tiles") )
+        job.tiles = a.get_string_argument("tiles");
+    if( a.is_set("binary") )
+        job.binary = a.get_string_argument("binary");
+    if( a.is_set("binary float64") )
+        job.binaryScalarSize = 8;
 
+#ifdef FDEB_WITH_GL
     // If visualization is enabled
     if( a.is_set("visualization") )
-    {
-        // Set graphical parameters
-        gGraph.set_graphics_params( a.get_double_argument("transparency") );
-
-        // Get bounding box
-        meerkat::mk_vector2 bottomLeft, topRight;
-        gGraph.get_bounding_box(bottomLeft, topRight, 20.0);
-        double gWidth = topRight.x() - bottomLeft.x();
-        double gHeight = topRight.y() - bottomLeft.y();
-
-        // Init GLUT
-        int wWidth = DEFAULT_SIZE, wHeight = DEFAULT_SIZE;
-        if( gWidth > gHeight )
-            wHeight = int(wWidth * gHeight/gWidth);
-        else
-            wWidth = int(wHeight * gWidth/gHeight);
-        glutInit( &argc_, argv_ );
-        glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE );
-        glutInitWindowSize( wWidth, wHeight );
-        glutInitWindowPosition( 10, 100 );
-        glutCreateWindow( "fdeb" );
-        init(bottomLeft, topRight);
-
-        // Increase cycle index and enter main loop
-        glutDisplayFunc( display );
-        glutKeyboardFunc( keyboard );
-        glutTimerFunc( 10, timer, 1 );
-        glutMainLoop();
-    }
-    // Otherwise, just perform edge bundling
-    else
-    {
-        do
-        {
-            while( gGraph.iterate() > 0 );
-            gGraph.add_subvisions();
-        } while( gGraph.update_cycle() > 0 );
-        gGraph.smooth();
-        if( gJson != "" )
-            gGraph.print_json(gJson);
-    }
+        run_viewer(graph, [&graph, &job] { job.finish(graph); }, &argc_, argv_);
+#endif
+
+    // Otherwise, just perform edge bundling, an interrupted run is still written
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+    graph.set_stop_flag(&stopRequested);
+    graph.run();
+    if( !job.finish(graph) )
+        return 1;
 
     return 0;
 }
@@ -0,0 +1,84 @@
+#include "meerkat_async_writer.hpp"
+#include "stdio.h"
+#include <unistd.h>
+
+
+/**
+ * Desc: Empty constructor.
+ */
+meerkat::mk_async_writer::mk_async_writer()
+{
+  _fileName = "_UNDEFINED_";
+  _succeeded = true;
+}
+
+
+/**
+ * Desc: Destructor, which waits for the pending write.
+ */
+meerkat::mk_async_writer::~mk_async_writer()
+{
+  wait();
+}
+
+
+/**
+ * Desc: Writes the buffer into the temporary file and renames it to the target.
+ * Runs on the background thread.
+ */
+void meerkat::mk_async_writer::write_file()
+{
+  std::string temporaryName = _fileName + ".tmp";
+  FILE *file = fopen( temporaryName.c_str(), "wb" );
+  if( file == NULL )
+  {
+    _succeeded = false;
+    return;
+  }
+  bool ok = fwrite( _buffer.data(), 1, _buffer.size(), file ) == _buffer.size();
+  ok = fflush( file ) == 0 && ok;
+  ok = fsync( fileno( file ) ) == 0 && ok;
+  ok = fclose( file ) == 0 && ok;
+  _succeeded = ok && rename( temporaryName.c_str(), _fileName.c_str() ) == 0;
+  if( !_succeeded )
+    remove( temporaryName.c_str() );
+}
+
+
+/**
+ * Desc: Returns the buffer to fill with the next content. Waits for the pending
+ * write, as the buffer is owned by the background thread until it finishes.
+ *
+ * return : buffer.
+ */
+std::vector<char> &meerkat::mk_async_writer::buffer()
+{
+  wait();
+  return _buffer;
+}
+
+
+/**
+ * Desc: Starts writing the buffer into a file in the background.
+ *
+ * @fileName_ : name of the file to write.
+ */
+void meerkat::mk_async_writer::write( const std::string fileName_ )
+{
+  wait();
+  _fileName = fileName_;
+  _thread = std::thread( &mk_async_writer::write_file, this );
+}
+
+
+/**
+ * Desc: Waits for the pending write.
+ *
+ * return : true if the last write succeeded.
+ */
+bool meerkat::mk_async_writer::wait()
+{
+  if( _thread.joinable() )
+    _thread.join();
+  return _succeeded;
+}
@@ -0,0 +1,38 @@
+/*
+ * Writes a buffer into a file on a background thread. The data is written into a
+ * temporary file next to the target which then replaces the target, so the target
+ * always holds a complete earlier or new version.
+ */
+
+#ifndef MEERKAT_ASYNC_WRITER_H
+#define MEERKAT_ASYNC_WRITER_H
+
+#include "stdlib.h"
+#include <vector>
+#include <string>
+#include <thread>
+
+namespace meerkat {
+
+  class mk_async_writer
+  {
+  private:
+    std::thread _thread;
+    std::vector<char> _buffer;
+    std::string _fileName;
+    bool _succeeded;
+
+    void write_file();
+
+  public:
+    mk_async_writer();
+    ~mk_async_writer();
+
+    std::vector<char> &buffer();
+    void write( const std::string fileName_ );
+    bool wait();
+  };
+
+}
+
+#endif // MEERKAT_ASYNC_WRITER_H
@@ -0,0 +1,175 @@
+#include "meerkat_buffered_writer.hpp"
+#include "string.h"
+#include <charconv>
+
+
+/**
+ * Desc: Empty constructor.
+ */
+meerkat::mk_buffered_writer::mk_buffered_writer()
+{
+  _filePointer = NULL;
+  _used = 0;
+  _failed = false;
+}
+
+
+/**
+ * Desc: Destructor, which flushes and closes the file if it is open.
+ */
+meerkat::mk_buffered_writer::~mk_buffered_writer()
+{
+  if( _filePointer != NULL )
+    close();
+}
+
+
+/**
+ * Desc: Opens a file for writing.
+ *
+ * @fileName_ : name of the file.
+ * return : true if the file could be opened.
+ */
+bool meerkat::mk_buffered_writer::open( const std::string fileName_ )
+{
+  if( _filePointer != NULL )
+    close();
+  _filePointer = fopen( fileName_.c_str(), "wb" );
+  _buffer.resize( MK_WRITER_BUFFER_SIZE );
+  _used = 0;
+  _failed = false;
+  return _filePointer != NULL;
+}
+
+
+/**
+ * Desc: Flushes the buffer and closes the file.
+ *
+ * return : true if everything has been written successfully.
+ */
+bool meerkat::mk_buffered_writer::close()
+{
+  if( _filePointer == NULL )
+    return false;
+  flush();
+  if( fclose( _filePointer ) != 0 )
+    _failed = true;
+  _filePointer = NULL;
+  return !_failed;
+}
+
+
+/**
+ * Desc: Writes the content of the buffer into the file.
+ */
+void meerkat::mk_buffered_writer::flush()
+{
+  if( _used > 0 && fwrite( _buffer.data(), 1, _used, _filePointer ) != _used )
+    _failed = true;
+  _used = 0;
+}
+
+
+/**
+ * Desc: Writes a text.
+ *
+ * @text_ : first character of the text.
+ * @length_ : length of the text.
+ */
+void meerkat::mk_buffered_writer::put( const char *text_, size_t length_ )
+{
+  if( _used + length_ > _buffer.size() )
+  {
+    flush();
+    // large blocks bypass the buffer
+    if( length_ > _buffer.size() )
+    {
+      if( fwrite( text_, 1, length_, _filePointer ) != length_ )
+        _failed = true;
+      return;
+    }
+  }
+  memcpy( _buffer.data() + _used, text_, length_ );
+  _used += length_;
+}
+
+
+/**
+ * Desc: Writes a zero terminated text.
+ *
+ * @text_ : text to write.
+ */
+void meerkat::mk_buffered_writer::put( const char *text_ )
+{
+  put( text_, strlen(text_) );
+}
+
+
+/**
+ * Desc: Writes a string.
+ *
+ * @text_ : text to write.
+ */
+void meerkat::mk_buffered_writer::put( const std::string &text_ )
+{
+  put( text_.data(), text_.length() );
+}
+
+
+/**
+ * Desc: Writes a single character.
+ *
+ * @character_ : character to write.
+ */
+void meerkat::mk_buffered_writer::put_char( char character_ )
+{
+  if( _used == _buffer.size() )
+    flush();
+  _buffer[_used++] = character_;
+}
+
+
+/**
+ * Desc: Writes a floating point number.
+ *
+ * @value_ : number to write.
+ * @precision_ : number of significant digits, 0 for the shortest representation
+ *               that reads back to the same value.
+ */
+void meerkat::mk_buffered_writer::put_double( double value_, int precision_ )
+{
+  char number[MK_MAX_NUMBER_LENGTH];
+  put( number, format_double( number, value_, precision_ ) );
+}
+
+
+/**
+ * Desc: Formats a floating point number like printf's %g, or in the shortest round-trip form.
+ *
+ * @buffer_ : buffer of at least MK_MAX_NUMBER_LENGTH characters, not zero terminated.
+ * @value_ : number to format.
+ * @precision_ : number of significant digits (at most 17), 0 for the shortest round-trip form.
+ * return : length of the formatted number.
+ */
+size_t meerkat::mk_buffered_writer::format_double( char *buffer_, double value_, int precision_ )
+{
+  std::to_chars_result result = precision_ > 0
+      ? std::to_chars( buffer_, buffer_ + MK_MAX_NUMBER_LENGTH, value_,
+                       std::chars_format::general, precision_ < 17 ? precision_ : 17 )
+      : std::to_chars( buffer_, buffer_ + MK_MAX_NUMBER_LENGTH, value_ );
+  return (size_t)(result.ptr - buffer_);
+}
+
+
+/**
+ * Desc: Appends a formatted floating point number to a string.
+ *
+ * @text_ : string to extend.
+ * @value_ : number to format.
+ * @precision_ : number of significant digits, 0 for the shortest round-trip form.
+ */
+void meerkat::mk_buffered_writer::append_double( std::string &text_, double value_, int precision_ )
+{
+  char number[MK_MAX_NUMBER_LENGTH];
+  text_.append( number, format_double( number, value_, precision_ ) );
+}
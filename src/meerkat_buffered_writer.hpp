@@ -0,0 +1,46 @@
+/*
+ * A file writer with a fixed size buffer. Text is collected in the buffer and
+ * written in large blocks, so memory does not grow with the output size.
+ */
+
+#ifndef MEERKAT_BUFFERED_WRITER_H
+#define MEERKAT_BUFFERED_WRITER_H
+
+#include "stdlib.h"
+#include "stdio.h"
+#include <vector>
+#include <string>
+
+#define MK_WRITER_BUFFER_SIZE (1 << 20)
+#define MK_MAX_NUMBER_LENGTH 32
+
+namespace meerkat {
+
+  class mk_buffered_writer
+  {
+  private:
+    FILE *_filePointer;
+    std::vector<char> _buffer;
+    size_t _used;
+    bool _failed;
+
+  public:
+    mk_buffered_writer();
+    ~mk_buffered_writer();
+
+    bool open( const std::string fileName_ );
+    bool close();
+    void flush();
+    void put( const char *text_, size_t length_ );
+    void put( const char *text_ );
+    void put( const std::string &text_ );
+    void put_char( char character_ );
+    void put_double( double value_, int precision_ );
+
+    static size_t format_double( char *buffer_, double value_, int precision_ );
+    static void append_double( std::string &text_, double value_, int precision_ );
+  };
+
+}
+
+#endif // MEERKAT_BUFFERED_WRITER_H
@@ -0,0 +1,126 @@
+#include "meerkat_image_writer.hpp"
+#include "string.h"
+#include <vector>
+#include <zlib.h>
+
+
+/**
+ * Desc: Writes a PNG chunk.
+ *
+ * @file_ : file to write.
+ * @type_ : four character chunk type.
+ * @data_ : chunk data.
+ * @length_ : length of the data.
+ * return : true if the chunk is written.
+ */
+static bool write_chunk( FILE *file_, const char *type_, const unsigned char *data_, size_t length_ )
+{
+  unsigned char header[8] = {
+    (unsigned char)(length_ >> 24), (unsigned char)(length_ >> 16),
+    (unsigned char)(length_ >> 8), (unsigned char)length_,
+    (unsigned char)type_[0], (unsigned char)type_[1], (unsigned char)type_[2], (unsigned char)type_[3]
+  };
+  uLong crc = crc32( 0L, header + 4, 4 );
+  if( length_ > 0 )
+    crc = crc32( crc, data_, (uInt)length_ );
+  unsigned char footer[4] = {
+    (unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+    (unsigned char)(crc >> 8), (unsigned char)crc
+  };
+  return fwrite( header, 1, 8, file_ ) == 8
+      && (length_ == 0 || fwrite( data_, 1, length_, file_ ) == length_)
+      && fwrite( footer, 1, 4, file_ ) == 4;
+}
+
+
+/**
+ * Desc: Writes an image in PNG format.
+ *
+ * @fileName_ : name of the file.
+ * @width_ : width of the image.
+ * @height_ : height of the image.
+ * @channels_ : 1 (gray), 3 (RGB) or 4 (RGBA).
+ * @pixels_ : row-major pixel values, top row first.
+ * return : true if the image is written.
+ */
+bool meerkat::mk_image_writer::write_png( const std::string fileName_, int width_, int height_,
+                                          int channels_, const unsigned char *pixels_ )
+{
+  // rows prefixed by filter type 0
+  size_t rowSize = (size_t)width_ * channels_;
+  std::vector<unsigned char> raw( (rowSize+1) * height_ );
+  for(int y=0; y<height_; y++)
+  {
+    raw[y*(rowSize+1)] = 0;
+    memcpy( &raw[y*(rowSize+1)+1], pixels_ + y*rowSize, rowSize );
+  }
+  uLongf compressedSize = compressBound( (uLong)raw.size() );
+  std::vector<unsigned char> compressed( compressedSize );
+  if( compress2( compressed.data(), &compressedSize, raw.data(), (uLong)raw.size(), MK_PNG_COMPRESSION_LEVEL ) != Z_OK )
+    return false;
+
+  unsigned char colorType = channels_ == 1 ? 0 : (channels_ == 3 ? 2 : 6);
+  unsigned char header[13] = {
+    (unsigned char)(width_ >> 24), (unsigned char)(width_ >> 16),
+    (unsigned char)(width_ >> 8), (unsigned char)width_,
+    (unsigned char)(height_ >> 24), (unsigned char)(height_ >> 16),
+    (unsigned char)(height_ >> 8), (unsigned char)height_,
+    8, colorType, 0, 0, 0
+  };
+  static const unsigned char SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+  FILE *file = fopen( fileName_.c_str(), "wb" );
+  if( file == NULL )
+    return false;
+  bool ok = fwrite( SIGNATURE, 1, 8, file ) == 8
+      && write_chunk( file, "IHDR", header, 13 )
+      && write_chunk( file, "IDAT", compressed.data(), compressedSize )
+      && write_chunk( file, "IEND", NULL, 0 );
+  return fclose( file ) == 0 && ok;
+}
+
+
+/**
+ * Desc: Writes an image in binary PGM (1 channel) or PPM (3 channels) format.
+ *
+ * @fileName_ : name of the file.
+ * @width_ : width of the image.
+ * @height_ : height of the image.
+ * @channels_ : 1 (gray) or 3 (RGB).
+ * @pixels_ : row-major pixel values, top row first.
+ * return : true if the image is written.
+ */
+bool meerkat::mk_image_writer::write_pnm( const std::string fileName_, int width_, int height_,
+                                          int channels_, const unsigned char *pixels_ )
+{
+  if( channels_ != 1 && channels_ != 3 )
+    return false;
+  FILE *file = fopen( fileName_.c_str(), "wb" );
+  if( file == NULL )
+    return false;
+  size_t size = (size_t)width_ * height_ * channels_;
+  bool ok = fprintf( file, "P%d\n%d %d\n255\n", channels_ == 1 ? 5 : 6, width_, height_ ) > 0
+      && fwrite( pixels_, 1, size, file ) == size;
+  return fclose( file ) == 0 && ok;
+}
+
+
+/**
+ * Desc: Writes an image, in PPM/PGM format if the file name ends with .ppm or .pgm and in PNG otherwise.
+ *
+ * @fileName_ : name of the file.
+ * @width_ : width of the image.
+ * @height_ : height of the image.
+ * @channels_ : number of channels.
+ * @pixels_ : row-major pixel values, top row first.
+ * return : true if the image is written.
+ */
+bool meerkat::mk_image_writer::write( const std::string fileName_, int width_, int height_,
+                                      int channels_, const unsigned char *pixels_ )
+{
+  size_t length = fileName_.length();
+  if( length > 4 && (fileName_.compare( length-4, 4, ".ppm" ) == 0
+                     || fileName_.compare( length-4, 4, ".pgm" ) == 0) )
+    return write_pnm( fileName_, width_, height_, channels_, pixels_ );
+  return write_png( fileName_, width_, height_, channels_, pixels_ );
+}
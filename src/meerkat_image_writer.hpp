@@ -0,0 +1,29 @@
+/*
+ * Writes 8-bit images in PNG (zlib compressed) or binary PPM/PGM format.
+ */
+
+#ifndef MEERKAT_IMAGE_WRITER_H
+#define MEERKAT_IMAGE_WRITER_H
+
+#include "stdlib.h"
+#include "stdio.h"
+#include <string>
+
+#define MK_PNG_COMPRESSION_LEVEL 1      // zlib level of PNG images, favouring speed over size.
+
+namespace meerkat {
+
+  class mk_image_writer
+  {
+  public:
+    static bool write_png( const std::string fileName_, int width_, int height_,
+                           int channels_, const unsigned char *pixels_ );
+    static bool write_pnm( const std::string fileName_, int width_, int height_,
+                           int channels_, const unsigned char *pixels_ );
+    static bool write( const std::string fileName_, int width_, int height_,
+                       int channels_, const unsigned char *pixels_ );
+  };
+
+}
+
+#endif // MEERKAT_IMAGE_WRITER_H
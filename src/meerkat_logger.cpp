@@ -1,7 +1,6 @@
 #include "meerkat_logger.hpp"
 
 // static members
-int meerkat::mk_log::_severityLevel = meerkat::mk_log::SLInfo;
 clock_t meerkat::mk_log::_startTime = clock();
 
 std::string meerkat::mk_log::_get_time_str() const
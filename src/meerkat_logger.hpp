@@ -27,7 +27,7 @@ namespace meerkat {
   private:
       // Member variables
       std::string _tag;
-      static int _severityLevel;
+      int _severityLevel;
       static clock_t _startTime;
 
       // Internal methods
@@ -51,11 +51,11 @@ namespace meerkat {
 
 
       /**
-       * Sets severity level.
+       * Sets severity level of this logger.
        *
        * @param policy_  policy to set
        */
-      static void severity_level( SeverityLevel severityLevel_ );
+      void severity_level( SeverityLevel severityLevel_ );
 
 
       /**
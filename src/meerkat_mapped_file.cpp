@@ -0,0 +1,243 @@
+#include "meerkat_mapped_file.hpp"
+#include "string.h"
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+/**
+ * Desc: Empty constructor.
+ */
+meerkat::mk_mapped_file::mk_mapped_file()
+{
+  _fileDescriptor = -1;
+  _data = NULL;
+  _size = 0;
+  _writable = false;
+  _mapped = false;
+  _fileName = "_UNDEFINED_";
+}
+
+
+/**
+ * Desc: Destructor, which unmaps and closes the file if it is open.
+ */
+meerkat::mk_mapped_file::~mk_mapped_file()
+{
+  close();
+}
+
+
+/**
+ * Desc: Reads the rest of the open file into the buffer, for files that cannot be mapped.
+ *
+ * return : true if the file could be read, false otherwise.
+ */
+bool meerkat::mk_mapped_file::read_buffer()
+{
+  size_t done = 0;
+  _buffer.resize( 65536 );
+  while( true )
+  {
+    if( done == _buffer.size() )
+      _buffer.resize( 2*_buffer.size() );
+    ssize_t n = read( _fileDescriptor, _buffer.data() + done, _buffer.size() - done );
+    if( n < 0 && errno == EINTR )
+      continue;
+    if( n < 0 )
+      return false;
+    if( n == 0 )
+      break;
+    done += (size_t)n;
+  }
+  _buffer.resize( done );
+  _size = done;
+  _data = done > 0 ? _buffer.data() : NULL;
+  return true;
+}
+
+
+/**
+ * Desc: Opens a file and maps its content into memory. Files other than regular files
+ * and files that cannot be mapped are read into a buffer instead.
+ *
+ * @fileName_ : name of the file to map.
+ * return : true if the file could be mapped or read, false otherwise.
+ */
+bool meerkat::mk_mapped_file::open( const std::string fileName_ )
+{
+  close();
+
+  _fileDescriptor = ::open( fileName_.c_str(), O_RDONLY );
+  if( _fileDescriptor < 0 )
+    return false;
+
+  struct stat fileStat;
+  if( fstat( _fileDescriptor, &fileStat ) != 0 )
+  {
+    close();
+    return false;
+  }
+  _fileName = fileName_;
+
+  // pipes report no size, they are read as they come
+  if( !S_ISREG( fileStat.st_mode ) )
+  {
+    if( !read_buffer() )
+    {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  // empty files cannot be mapped, they are simply empty
+  _size = (size_t)fileStat.st_size;
+  if( _size == 0 )
+    return true;
+
+  void *mapping = mmap( NULL, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0 );
+  if( mapping == MAP_FAILED )
+  {
+    if( !read_buffer() )
+    {
+      close();
+      return false;
+    }
+    return true;
+  }
+  _data = (char *)mapping;
+  _mapped = true;
+  madvise( _data, _size, MADV_SEQUENTIAL );
+
+  return true;
+}
+
+
+/**
+ * Desc: Creates (or truncates) a file of the given size and maps it for writing.
+ * The disk space is reserved up front, so that writing through the mapping does not
+ * fail (with SIGBUS) when the disk is full.
+ *
+ * @fileName_ : name of the file to create.
+ * @size_ : size of the file in bytes.
+ * return : true if the file could be created, its space reserved and mapped, false otherwise.
+ */
+bool meerkat::mk_mapped_file::create( const std::string fileName_, size_t size_ )
+{
+  close();
+
+  _fileDescriptor = ::open( fileName_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( _fileDescriptor < 0 )
+    return false;
+#ifdef __APPLE__
+  // no posix_fallocate, the file is extended without reserving space
+  bool reserved = ftruncate( _fileDescriptor, (off_t)size_ ) == 0;
+#else
+  bool reserved = size_ == 0 || posix_fallocate( _fileDescriptor, 0, (off_t)size_ ) == 0;
+#endif
+  if( !reserved )
+  {
+    close();
+    return false;
+  }
+  _fileName = fileName_;
+  _size = size_;
+  _writable = true;
+  if( _size == 0 )
+    return true;
+
+  void *mapping = mmap( NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fileDescriptor, 0 );
+  if( mapping == MAP_FAILED )
+  {
+    close();
+    return false;
+  }
+  _data = (char *)mapping;
+  _mapped = true;
+
+  return true;
+}
+
+
+/**
+ * Desc: Unmaps and closes the file. Written pages are stored before unmapping, as
+ * munmap and close do not report write errors.
+ *
+ * return : false if storing, unmapping or closing failed.
+ */
+bool meerkat::mk_mapped_file::close()
+{
+  bool ok = true;
+  if( _mapped && _writable )
+    ok = msync( _data, _size, MS_SYNC ) == 0;
+  if( _mapped )
+    ok = munmap( _data, _size ) == 0 && ok;
+  if( _fileDescriptor >= 0 )
+    ok = ::close( _fileDescriptor ) == 0 && ok;
+  _fileDescriptor = -1;
+  _data = NULL;
+  _size = 0;
+  _writable = false;
+  _mapped = false;
+  std::vector<char>().swap( _buffer );
+  _fileName = "_UNDEFINED_";
+  return ok;
+}
+
+
+/**
+ * Desc: Returns the beginning of the mapped content.
+ *
+ * return : pointer to the first byte (NULL for empty files).
+ */
+const char *meerkat::mk_mapped_file::data() const
+{
+  return _data;
+}
+
+
+/**
+ * Desc: Returns the beginning of the mapped content for writing.
+ *
+ * return : pointer to the first byte (NULL for empty files).
+ */
+char *meerkat::mk_mapped_file::data()
+{
+  return _data;
+}
+
+
+/**
+ * Desc: Returns the size of the mapped content.
+ *
+ * return : size in bytes.
+ */
+size_t meerkat::mk_mapped_file::size() const
+{
+  return _size;
+}
+
+
+/**
+ * Desc: Splits the content into chunks of roughly equal size that begin at line starts.
+ *
+ * @chunks_ : number of chunks.
+ * @bounds_ : offsets of the chunk boundaries (chunks_+1 values, the last being the size).
+ */
+void meerkat::mk_mapped_file::split_lines( int chunks_, std::vector<size_t> &bounds_ ) const
+{
+  bounds_.assign( chunks_+1, _size );
+  bounds_[0] = 0;
+  for(int c=1; c<chunks_; c++)
+  {
+    size_t offset = std::max( bounds_[c-1], _size / chunks_ * c );
+    const char *lineEnd = offset < _size
+        ? (const char *)memchr( _data + offset, '\n', _size - offset )
+        : NULL;
+    bounds_[c] = lineEnd == NULL ? _size : (size_t)(lineEnd - _data) + 1;
+  }
+}
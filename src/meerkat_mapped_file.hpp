@@ -0,0 +1,45 @@
+/*
+ * A memory-mapped file, either an existing file mapped read-only or a new
+ * file of given size mapped for writing. Files that cannot be mapped, such as
+ * pipes, are read into a buffer instead. The mapping is released when the
+ * object is destroyed.
+ */
+
+#ifndef MEERKAT_MAPPED_FILE_H
+#define MEERKAT_MAPPED_FILE_H
+
+#include "stdlib.h"
+#include <vector>
+#include <string>
+
+namespace meerkat {
+
+  class mk_mapped_file
+  {
+  private:
+    int _fileDescriptor;
+    char *_data;
+    size_t _size;
+    bool _writable;
+    bool _mapped;
+    std::vector<char> _buffer;
+    std::string _fileName;
+
+    bool read_buffer();
+
+  public:
+    mk_mapped_file();
+    ~mk_mapped_file();
+
+    bool open( const std::string fileName_ );
+    bool create( const std::string fileName_, size_t size_ );
+    bool close();
+    const char *data() const;
+    char *data();
+    size_t size() const;
+    void split_lines( int chunks_, std::vector<size_t> &bounds_ ) const;
+  };
+
+}
+
+#endif // MEERKAT_MAPPED_FILE_H
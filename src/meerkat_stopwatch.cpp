@@ -0,0 +1,30 @@
+#include "meerkat_stopwatch.hpp"
+
+
+/**
+ * Desc: Constructor, which starts the stopwatch.
+ */
+meerkat::mk_stopwatch::mk_stopwatch()
+{
+  restart();
+}
+
+
+/**
+ * Desc: Starts measuring again from now.
+ */
+void meerkat::mk_stopwatch::restart()
+{
+  _start = std::chrono::steady_clock::now();
+}
+
+
+/**
+ * Desc: Returns the time elapsed since the start.
+ *
+ * return : elapsed time in seconds.
+ */
+double meerkat::mk_stopwatch::seconds() const
+{
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - _start ).count();
+}
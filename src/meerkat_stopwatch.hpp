@@ -0,0 +1,26 @@
+/*
+ * Measures wall-clock time on the steady clock, starting when it is created.
+ */
+
+#ifndef MEERKAT_STOPWATCH_H
+#define MEERKAT_STOPWATCH_H
+
+#include <chrono>
+
+namespace meerkat {
+
+  class mk_stopwatch
+  {
+  private:
+    std::chrono::steady_clock::time_point _start;
+
+  public:
+    mk_stopwatch();
+
+    void restart();
+    double seconds() const;
+  };
+
+}
+
+#endif // MEERKAT_STOPWATCH_H
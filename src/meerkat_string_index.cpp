@@ -0,0 +1,158 @@
+#include "meerkat_string_index.hpp"
+#include "string.h"
+
+#define MK_EMPTY_SLOT 0xffffffffu
+#define MK_MIN_SLOTS 16
+
+
+/**
+ * Desc: Empty constructor.
+ */
+meerkat::mk_string_index::mk_string_index()
+{
+  clear();
+}
+
+
+/**
+ * Desc: FNV-1a hash of a string.
+ *
+ * @key_ : first character of the string.
+ * @length_ : length of the string.
+ * return : hash value.
+ */
+uint64_t meerkat::mk_string_index::hash( const char *key_, size_t length_ )
+{
+  uint64_t h = 14695981039346656037ULL;
+  for(size_t i=0; i<length_; i++)
+  {
+    h ^= (unsigned char)key_[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+
+/**
+ * Desc: Rebuilds the hash table with the given number of slots (a power of two).
+ *
+ * @slotsNum_ : new number of slots.
+ */
+void meerkat::mk_string_index::rehash( size_t slotsNum_ )
+{
+  _slots.assign( slotsNum_, MK_EMPTY_SLOT );
+  _mask = slotsNum_ - 1;
+  for(size_t id=0; id<_keys.size(); id++)
+  {
+    uint64_t slot = _hashes[id] & _mask;
+    while( _slots[slot] != MK_EMPTY_SLOT )
+      slot = (slot + 1) & _mask;
+    _slots[slot] = (uint32_t)id;
+  }
+}
+
+
+/**
+ * Desc: Removes all strings.
+ */
+void meerkat::mk_string_index::clear()
+{
+  _keys.clear();
+  _hashes.clear();
+  _slots.assign( MK_MIN_SLOTS, MK_EMPTY_SLOT );
+  _mask = MK_MIN_SLOTS - 1;
+}
+
+
+/**
+ * Desc: Prepares the index for the given number of strings.
+ *
+ * @size_ : expected number of strings.
+ */
+void meerkat::mk_string_index::reserve( size_t size_ )
+{
+  _keys.reserve( size_ );
+  _hashes.reserve( size_ );
+  size_t slotsNum = MK_MIN_SLOTS;
+  while( slotsNum < 2*size_ )
+    slotsNum *= 2;
+  if( slotsNum > _slots.size() )
+    rehash( slotsNum );
+}
+
+
+/**
+ * Desc: Returns the number of strings.
+ *
+ * return : number of interned strings.
+ */
+size_t meerkat::mk_string_index::size() const
+{
+  return _keys.size();
+}
+
+
+/**
+ * Desc: Interns a string.
+ *
+ * @key_ : first character of the string.
+ * @length_ : length of the string.
+ * return : id of the string, which is the number of strings before its first insertion.
+ */
+uint32_t meerkat::mk_string_index::insert( const char *key_, size_t length_ )
+{
+  uint32_t id;
+  if( find( key_, length_, id ) )
+    return id;
+
+  // keep load factor below 1/2
+  if( 2*(_keys.size()+1) > _slots.size() )
+    rehash( 2*_slots.size() );
+
+  id = (uint32_t)_keys.size();
+  uint64_t h = hash( key_, length_ );
+  _keys.push_back( std::string(key_, length_) );
+  _hashes.push_back( h );
+  uint64_t slot = h & _mask;
+  while( _slots[slot] != MK_EMPTY_SLOT )
+    slot = (slot + 1) & _mask;
+  _slots[slot] = id;
+  return id;
+}
+
+
+/**
+ * Desc: Looks up a string.
+ *
+ * @key_ : first character of the string.
+ * @length_ : length of the string.
+ * @id_ : id of the string if found.
+ * return : true if the string is interned.
+ */
+bool meerkat::mk_string_index::find( const char *key_, size_t length_, uint32_t &id_ ) const
+{
+  uint64_t h = hash( key_, length_ );
+  for(uint64_t slot = h & _mask; _slots[slot] != MK_EMPTY_SLOT; slot = (slot + 1) & _mask)
+  {
+    uint32_t id = _slots[slot];
+    if( _hashes[id] == h && _keys[id].length() == length_
+        && memcmp( _keys[id].data(), key_, length_ ) == 0 )
+    {
+      id_ = id;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * Desc: Returns an interned string.
+ *
+ * @id_ : id of the string.
+ * return : the string.
+ */
+const std::string &meerkat::mk_string_index::key( uint32_t id_ ) const
+{
+  return _keys[id_];
+}
@@ -0,0 +1,40 @@
+/*
+ * Interns strings into dense integer ids. Lookups go through an open
+ * addressing hash table with linear probing.
+ */
+
+#ifndef MEERKAT_STRING_INDEX_H
+#define MEERKAT_STRING_INDEX_H
+
+#include "stdlib.h"
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+namespace meerkat {
+
+  class mk_string_index
+  {
+  private:
+    std::vector<std::string> _keys;
+    std::vector<uint64_t> _hashes;
+    std::vector<uint32_t> _slots;
+    uint64_t _mask;
+
+    static uint64_t hash( const char *key_, size_t length_ );
+    void rehash( size_t slotsNum_ );
+
+  public:
+    mk_string_index();
+
+    void clear();
+    void reserve( size_t size_ );
+    size_t size() const;
+    uint32_t insert( const char *key_, size_t length_ );
+    bool find( const char *key_, size_t length_, uint32_t &id_ ) const;
+    const std::string &key( uint32_t id_ ) const;
+  };
+
+}
+
+#endif // MEERKAT_STRING_INDEX_H
@@ -0,0 +1,55 @@
+#include "meerkat_table_writer.hpp"
+#include "stdio.h"
+#include <stdarg.h>
+#include <vector>
+
+
+/**
+ * Desc: Empty constructor.
+ */
+meerkat::mk_table_writer::mk_table_writer()
+{
+}
+
+
+/**
+ * Desc: Appends a line, the newline is added.
+ *
+ * @format_ : printf format of the line, with tabs between the columns.
+ * @... : values of the format.
+ */
+void meerkat::mk_table_writer::line( const char *format_, ... )
+{
+  va_list arguments;
+  va_start( arguments, format_ );
+  va_list copy;
+  va_copy( copy, arguments );
+  int length = vsnprintf( NULL, 0, format_, copy );
+  va_end( copy );
+  if( length > 0 )
+  {
+    std::vector<char> buffer( length+1 );
+    vsnprintf( &buffer[0], buffer.size(), format_, arguments );
+    _text.append( &buffer[0], length );
+  }
+  va_end( arguments );
+  _text += '\n';
+}
+
+
+/**
+ * Desc: Writes the table.
+ *
+ * @fileName_ : name of the file, the standard output if empty.
+ * return : true if the table is written.
+ */
+bool meerkat::mk_table_writer::write( const std::string fileName_ ) const
+{
+  FILE *file = fileName_ == "" ? stdout : fopen( fileName_.c_str(), "w" );
+  if( file == NULL )
+    return false;
+  bool ok = fwrite( _text.data(), 1, _text.size(), file ) == _text.size();
+  if( file == stdout )
+    return fflush( file ) == 0 && ok;
+  return fclose( file ) == 0 && ok;
+}
@@ -0,0 +1,28 @@
+/*
+ * Collects the lines of a tab separated table and writes them into a file or the
+ * standard output.
+ */
+
+#ifndef MEERKAT_TABLE_WRITER_H
+#define MEERKAT_TABLE_WRITER_H
+
+#include "stdlib.h"
+#include <string>
+
+namespace meerkat {
+
+  class mk_table_writer
+  {
+  private:
+    std::string _text;
+
+  public:
+    mk_table_writer();
+
+    void line( const char *format_, ... );
+    bool write( const std::string fileName_ ) const;
+  };
+
+}
+
+#endif // MEERKAT_TABLE_WRITER_H
@@ -0,0 +1,174 @@
+#include "meerkat_tokenizer.hpp"
+#include "string.h"
+#include <string>
+
+#define MK_MAX_MANTISSA_DIGITS 19
+#define MK_MAX_EXACT_MANTISSA 9007199254740992ULL
+#define MK_MAX_EXACT_EXPONENT 22
+
+static const double POWERS_OF_TEN[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/**
+ * Desc: Constructor with the text range to tokenize.
+ *
+ * @begin_ : first character.
+ * @end_ : one past the last character.
+ */
+meerkat::mk_tokenizer::mk_tokenizer( const char *begin_, const char *end_ )
+{
+  _pos = begin_;
+  _end = end_;
+}
+
+
+/**
+ * Desc: Checks if the whole text is consumed.
+ *
+ * return : true if there are no characters left.
+ */
+bool meerkat::mk_tokenizer::at_end() const
+{
+  return _pos >= _end;
+}
+
+
+/**
+ * Desc: Skips the rest of the current line.
+ *
+ * return : true if there is a next line to read.
+ */
+bool meerkat::mk_tokenizer::next_line()
+{
+  const char *lineEnd = _pos < _end ? (const char *)memchr( _pos, '\n', _end - _pos ) : NULL;
+  _pos = lineEnd == NULL ? _end : lineEnd + 1;
+  return _pos < _end;
+}
+
+
+/**
+ * Desc: Reads the next token of the current line.
+ *
+ * @token_ : pointer to the first character of the token.
+ * @length_ : length of the token.
+ * return : false if the line has no more tokens.
+ */
+bool meerkat::mk_tokenizer::next_token( const char *&token_, size_t &length_ )
+{
+  while( _pos < _end && (*_pos == ' ' || *_pos == '\t' || *_pos == '\r') )
+    _pos++;
+  if( _pos >= _end || *_pos == '\n' )
+    return false;
+
+  token_ = _pos;
+  while( _pos < _end && *_pos != ' ' && *_pos != '\t' && *_pos != '\r' && *_pos != '\n' )
+    _pos++;
+  length_ = (size_t)(_pos - token_);
+  return true;
+}
+
+
+/**
+ * Desc: Parses a decimal floating point number. Numbers whose significant digits fit in a double
+ * and have small exponents are converted exactly without library calls, everything else falls
+ * back to strtod.
+ *
+ * @token_ : first character of the number.
+ * @length_ : length of the number.
+ * @value_ : parsed value.
+ * return : true if the token is a valid number.
+ */
+bool meerkat::mk_tokenizer::parse_double( const char *token_, size_t length_, double &value_ )
+{
+  const char *p = token_, *end = token_ + length_;
+  bool negative = false, hasDigits = false, exact = true;
+  unsigned long long mantissa = 0;
+  int digits = 0, exponent = 0;
+
+  // sign
+  if( p < end && (*p == '-' || *p == '+') )
+  {
+    negative = *p == '-';
+    p++;
+  }
+
+  // integer part
+  for( ; p < end && *p >= '0' && *p <= '9'; p++ )
+  {
+    hasDigits = true;
+    if( digits < MK_MAX_MANTISSA_DIGITS )
+    {
+      mantissa = 10*mantissa + (*p - '0');
+      if( mantissa > 0 )
+        digits++;
+    }
+    else
+    {
+      exponent++;
+      exact = false;
+    }
+  }
+
+  // fractional part
+  if( p < end && *p == '.' )
+  {
+    for( p++; p < end && *p >= '0' && *p <= '9'; p++ )
+    {
+      hasDigits = true;
+      if( digits < MK_MAX_MANTISSA_DIGITS )
+      {
+        mantissa = 10*mantissa + (*p - '0');
+        if( mantissa > 0 )
+          digits++;
+        exponent--;
+      }
+      else
+        exact = false;
+    }
+  }
+
+  // exponent
+  if( hasDigits && p < end && (*p == 'e' || *p == 'E') )
+  {
+    p++;
+    bool negativeExponent = false;
+    if( p < end && (*p == '-' || *p == '+') )
+    {
+      negativeExponent = *p == '-';
+      p++;
+    }
+    int e = 0;
+    bool hasExponentDigits = false;
+    for( ; p < end && *p >= '0' && *p <= '9'; p++ )
+    {
+      hasExponentDigits = true;
+      if( e < 100000 )
+        e = 10*e + (*p - '0');
+    }
+    if( !hasExponentDigits )
+      exact = false;
+    exponent += negativeExponent ? -e : e;
+  }
+
+  // fast path: both the mantissa and the power of ten are exact doubles
+  if( hasDigits && exact && p == end && mantissa <= MK_MAX_EXACT_MANTISSA
+      && exponent >= -MK_MAX_EXACT_EXPONENT && exponent <= MK_MAX_EXACT_EXPONENT )
+  {
+    double value = (double)mantissa;
+    if( exponent < 0 )
+      value /= POWERS_OF_TEN[-exponent];
+    else
+      value *= POWERS_OF_TEN[exponent];
+    value_ = negative ? -value : value;
+    return true;
+  }
+
+  // slow path
+  std::string number( token_, length_ );
+  char *numberEnd = NULL;
+  value_ = strtod( number.c_str(), &numberEnd );
+  return numberEnd != number.c_str() && *numberEnd == '\0';
+}
@@ -0,0 +1,31 @@
+/*
+ * A lightweight tokenizer for white-space separated text held in memory.
+ * Tokens point into the original buffer, nothing is copied.
+ */
+
+#ifndef MEERKAT_TOKENIZER_H
+#define MEERKAT_TOKENIZER_H
+
+#include "stdlib.h"
+
+namespace meerkat {
+
+  class mk_tokenizer
+  {
+  private:
+    const char *_pos;
+    const char *_end;
+
+  public:
+    mk_tokenizer( const char *begin_, const char *end_ );
+
+    bool at_end() const;
+    bool next_line();
+    bool next_token( const char *&token_, size_t &length_ );
+
+    static bool parse_double( const char *token_, size_t length_, double &value_ );
+  };
+
+}
+
+#endif // MEERKAT_TOKENIZER_H
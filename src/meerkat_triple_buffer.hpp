@@ -0,0 +1,51 @@
+/*
+ * Lock-free exchange of snapshots between a single producer and a single
+ * consumer. The producer fills the back buffer and publishes it, the consumer
+ * takes the latest published buffer. Neither side ever waits for the other.
+ */
+
+#ifndef MEERKAT_TRIPLE_BUFFER_H
+#define MEERKAT_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+#define MK_TRIPLE_BUFFER_FRESH 4        // Marks that the middle buffer has not been consumed yet.
+#define MK_TRIPLE_BUFFER_INDEX 3        // Mask of the buffer index.
+
+namespace meerkat {
+
+  template <typename T>
+  class mk_triple_buffer
+  {
+  private:
+    T _buffers[3];
+    std::atomic<int> _middle;           // Index of the buffer between producer and consumer.
+    int _back;                          // Index of the buffer of the producer.
+    int _front;                         // Index of the buffer of the consumer.
+
+  public:
+    mk_triple_buffer() : _middle(1), _back(0), _front(2) {}
+
+    // producer side
+    T &back() { return _buffers[_back]; }
+    bool is_consumed() const { return (_middle.load(std::memory_order_acquire) & MK_TRIPLE_BUFFER_FRESH) == 0; }
+    void publish()
+    {
+      _back = _middle.exchange(_back | MK_TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel)
+          & MK_TRIPLE_BUFFER_INDEX;
+    }
+
+    // consumer side
+    const T &front() const { return _buffers[_front]; }
+    bool consume()
+    {
+      if( (_middle.load(std::memory_order_acquire) & MK_TRIPLE_BUFFER_FRESH) == 0 )
+        return false;
+      _front = _middle.exchange(_front, std::memory_order_acq_rel) & MK_TRIPLE_BUFFER_INDEX;
+      return true;
+    }
+  };
+
+}
+
+#endif // MEERKAT_TRIPLE_BUFFER_H
@@ -2,12 +2,11 @@
 #define NODE_HPP
 
 #include "meerkat_vector2.hpp"
-#include "GLUT/glut.h"
 
-#define NUM_SEGMENTS 16
-#define COS_THETA 0.92387953251
-#define SIN_THETA 0.38268343236
-#define RADIUS 1.0
+#define NUM_SEGMENTS 16                 // Number of segments of the node circle.
+#define COS_THETA 0.92387953251         // Cosine of the angle of a segment.
+#define SIN_THETA 0.38268343236         // Sine of the angle of a segment.
+#define RADIUS 1.0                      // Radius of nodes.
 
 // Node struct
 struct Node
@@ -28,11 +27,6 @@ struct Node
      * @param y_ Y coordinate.
      */
     Node(double x_, double y_);
-
-    /**
-     * @brief draw Draws the node.
-     */
-    void draw();
 };
 
 #endif // NODE_HPP
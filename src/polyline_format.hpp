@@ -0,0 +1,37 @@
+#ifndef POLYLINE_FORMAT_HPP
+#define POLYLINE_FORMAT_HPP
+
+#include <stdint.h>
+
+// Binary polyline file layout (native byte order, sections at the offsets given in the header,
+// all of them 8-byte aligned):
+//   PolylineFileHeader
+//   scalar    nodes[2*nodesNum]            x0 y0 x1 y1 ... node positions
+//   uint32_t  endpoints[2*edgesNum]        source and target node index of each edge
+//   uint64_t  offsets[edgesNum+1]          index of the first point of each edge in points
+//   scalar    points[2*pointsNum]          x0 y0 x1 y1 ... polylines including their end points
+// where scalar is float (scalarSize = 4) or double (scalarSize = 8).
+// Points of edge i are points[2*offsets[i]] ... points[2*offsets[i+1]-1].
+
+#define POLYLINE_FILE_MAGIC "FDEBPOLY"
+#define POLYLINE_FILE_VERSION 1
+#define POLYLINE_FILE_BYTE_ORDER 0x01020304u
+
+// Header of the binary polyline file
+struct PolylineFileHeader
+{
+    char magic[8];              // POLYLINE_FILE_MAGIC without terminating zero.
+    uint32_t version;           // POLYLINE_FILE_VERSION.
+    uint32_t byteOrder;         // POLYLINE_FILE_BYTE_ORDER as written by the producer.
+    uint32_t scalarSize;        // Size of coordinates in bytes (4 or 8).
+    uint32_t reserved;          // Padding, zero.
+    uint64_t nodesNum;          // Number of nodes.
+    uint64_t edgesNum;          // Number of edges.
+    uint64_t pointsNum;         // Total number of polyline points.
+    uint64_t nodesOffset;       // Byte offset of the node positions.
+    uint64_t endpointsOffset;   // Byte offset of the edge end points.
+    uint64_t offsetsOffset;     // Byte offset of the point offsets.
+    uint64_t pointsOffset;      // Byte offset of the polyline points.
+};
+
+#endif // POLYLINE_FORMAT_HPP
@@ -0,0 +1,417 @@
+#include "rasterizer.hpp"
+#include <algorithm>
+#include <cmath>
+
+Rasterizer::Rasterizer(const std::vector<Edge> &edges_, const std::vector<Node> &nodes_,
+                       double alpha_)
+    : _edges(edges_), _nodes(nodes_), _alpha((float)alpha_)
+{
+}
+
+const meerkat::mk_vector2 &Rasterizer::point(const Edge &edge_, int index_)
+{
+    if( index_ == 0 )
+        return edge_._start;
+    if( index_ > (int)edge_._subdivs.size() )
+        return edge_._end;
+    return edge_._subdivs[index_-1];
+}
+
+void Rasterizer::cover_segment(double x0_, double y0_, double x1_, double y1_, double halfWidth_,
+                               int width_, int height_, float *coverage_, int *rows_)
+{
+    // pixels closer than half width + 0.5 to the segment are (partially) covered
+    double reach = halfWidth_ + 0.5;
+    int xMin = std::max(0, (int)std::floor(std::min(x0_, x1_) - reach));
+    int xMax = std::min(width_-1, (int)std::floor(std::max(x0_, x1_) + reach));
+    int yMin = std::max(0, (int)std::floor(std::min(y0_, y1_) - reach));
+    int yMax = std::min(height_-1, (int)std::floor(std::max(y0_, y1_) + reach));
+    if( xMin > xMax || yMin > yMax )
+        return;
+
+    double dx = x1_ - x0_, dy = y1_ - y0_;
+    double len2 = dx*dx + dy*dy;
+    double inv = len2 > 0.0 ? 1.0/len2 : 0.0;
+    double band = std::abs(dy) > EPSILON ? reach * std::sqrt(len2) / std::abs(dy) : 0.0;
+    for( int y=yMin; y<=yMax; y++ )
+    {
+        double py = y + 0.5 - y0_;
+        float *row = coverage_ + y*width_;
+
+        // only pixels in the band around the line can be covered
+        int xFirst = xMin, xLast = xMax;
+        if( band > 0.0 )
+        {
+            double xc = x0_ + py*dx/dy;
+            xFirst = std::max(xMin, (int)std::floor(xc - band - 0.5));
+            xLast = std::min(xMax, (int)std::floor(xc + band + 0.5));
+        }
+        if( xFirst > xLast )
+            continue;
+        rows_[2*y] = std::min(rows_[2*y], xFirst);
+        rows_[2*y+1] = std::max(rows_[2*y+1], xLast);
+        for( int x=xFirst; x<=xLast; x++ )
+        {
+            double px = x + 0.5 - x0_;
+            double t = std::min(1.0, std::max(0.0, (px*dx + py*dy) * inv));
+            double ex = px - t*dx, ey = py - t*dy;
+            double c = reach - std::sqrt(ex*ex + ey*ey);
+            if( c > 0.0 )
+                row[x] = std::max(row[x], (float)std::min(c, 1.0));
+        }
+    }
+}
+
+void Rasterizer::bin_segments(double left_, double top_, double scale_, int tileSize_,
+                              int tilesX_, int tilesY_,
+                              std::vector<size_t> &offsets_,
+                              std::vector<SegmentRef> &segments_) const
+{
+    // count segments per tile first, then fill them in edge order
+    int edgesNum = (int)_edges.size();
+    offsets_.assign((size_t)tilesX_*tilesY_ + 1, 0);
+    for( int pass=0; pass<2; pass++ )
+    {
+        if( pass == 1 )
+        {
+            size_t total = 0, count;
+            for( size_t t=0; t+1<offsets_.size(); t++ )
+            {
+                count = offsets_[t];
+                offsets_[t] = total;
+                total += count;
+            }
+            offsets_.back() = total;
+            segments_.resize(total);
+        }
+        std::vector<size_t> next(offsets_.begin(), offsets_.end()-1);
+        for( int i=0; i<edgesNum; i++ )
+        {
+            const Edge &edge = _edges[i];
+            double reach = 0.5*edge.stroke_width() + 1.0;
+            int pointsNum = (int)edge._subdivs.size() + 2;
+            for( int j=0; j+1<pointsNum; j++ )
+            {
+                const meerkat::mk_vector2 &a = point(edge, j), &b = point(edge, j+1);
+                double ax = (a.x()-left_)*scale_, ay = (top_-a.y())*scale_;
+                double bx = (b.x()-left_)*scale_, by = (top_-b.y())*scale_;
+                int tx0 = std::max(0, (int)std::floor((std::min(ax, bx) - reach) / tileSize_));
+                int tx1 = std::min(tilesX_-1, (int)std::floor((std::max(ax, bx) + reach) / tileSize_));
+                int ty0 = std::max(0, (int)std::floor((std::min(ay, by) - reach) / tileSize_));
+                int ty1 = std::min(tilesY_-1, (int)std::floor((std::max(ay, by) + reach) / tileSize_));
+                for( int ty=ty0; ty<=ty1; ty++ )
+                    for( int tx=tx0; tx<=tx1; tx++ )
+                    {
+                        size_t tile = (size_t)ty*tilesX_ + tx;
+                        if( pass == 0 )
+                            offsets_[tile]++;
+                        else
+                        {
+                            segments_[next[tile]]._edge = (uint32_t)i;
+                            segments_[next[tile]]._index = (uint32_t)j;
+                            next[tile]++;
+                        }
+                    }
+            }
+        }
+    }
+}
+
+void Rasterizer::tile_columns(double ax_, double ay_, double bx_, double by_, double reach_,
+                              int tileSize_, int tilesNum_, int row_, int &first_, int &last_)
+{
+    // horizontal extent of the segment within the row of tiles and its reach
+    double xMin = std::min(ax_, bx_), xMax = std::max(ax_, bx_);
+    if( std::abs(by_ - ay_) > EPSILON )
+    {
+        double t0 = ((double)row_*tileSize_ - reach_ - ay_) / (by_ - ay_);
+        double t1 = ((double)(row_+1)*tileSize_ + reach_ - ay_) / (by_ - ay_);
+        t0 = std::min(1.0, std::max(0.0, t0));
+        t1 = std::min(1.0, std::max(0.0, t1));
+        xMin = std::min(ax_ + t0*(bx_ - ax_), ax_ + t1*(bx_ - ax_));
+        xMax = std::max(ax_ + t0*(bx_ - ax_), ax_ + t1*(bx_ - ax_));
+    }
+    first_ = std::max(0, (int)std::floor((xMin - reach_) / tileSize_));
+    last_ = std::min(tilesNum_-1, (int)std::floor((xMax + reach_) / tileSize_));
+}
+
+void Rasterizer::segment_rows(const Edge &edge_, int index_, double left_, double top_,
+                              double scale_, int tileSize_, int tilesNum_,
+                              double *a_, double *b_, int &first_, int &last_)
+{
+    const meerkat::mk_vector2 &a = point(edge_, index_), &b = point(edge_, index_+1);
+    double reach = 0.5*edge_.stroke_width() + 1.0;
+    a_[0] = (a.x()-left_)*scale_;
+    a_[1] = (top_-a.y())*scale_;
+    b_[0] = (b.x()-left_)*scale_;
+    b_[1] = (top_-b.y())*scale_;
+    first_ = std::max(0, (int)std::floor((std::min(a_[1], b_[1]) - reach) / tileSize_));
+    last_ = std::min(tilesNum_-1, (int)std::floor((std::max(a_[1], b_[1]) + reach) / tileSize_));
+}
+
+void Rasterizer::count_segments_sparse(double left_, double top_, double scale_, int tileSize_,
+                                       int tilesNum_, std::vector<size_t> &counts_) const
+{
+    counts_.assign(tilesNum_, 0);
+    int edgesNum = (int)_edges.size();
+    for( int i=0; i<edgesNum; i++ )
+    {
+        const Edge &edge = _edges[i];
+        double reach = 0.5*edge.stroke_width() + 1.0;
+        int pointsNum = (int)edge._subdivs.size() + 2;
+        for( int j=0; j+1<pointsNum; j++ )
+        {
+            double a[2], b[2];
+            int ty0, ty1, tx0, tx1;
+            segment_rows(edge, j, left_, top_, scale_, tileSize_, tilesNum_, a, b, ty0, ty1);
+            for( int ty=ty0; ty<=ty1; ty++ )
+            {
+                tile_columns(a[0], a[1], b[0], b[1], reach, tileSize_, tilesNum_, ty, tx0, tx1);
+                counts_[ty] += tx1 >= tx0 ? tx1 - tx0 + 1 : 0;
+            }
+        }
+    }
+}
+
+void Rasterizer::bin_segments_sparse(double left_, double top_, double scale_, int tileSize_,
+                                     int tilesNum_, int rowFirst_, int rowLast_,
+                                     std::vector<uint64_t> &tiles_, std::vector<size_t> &offsets_,
+                                     std::vector<SegmentRef> &segments_) const
+{
+    // segments are listed with their tiles in edge order, a stable sort keeps that order
+    // within the tiles
+    std::vector<std::pair<uint64_t, SegmentRef> > binned;
+    int edgesNum = (int)_edges.size();
+    for( int i=0; i<edgesNum; i++ )
+    {
+        const Edge &edge = _edges[i];
+        double reach = 0.5*edge.stroke_width() + 1.0;
+        int pointsNum = (int)edge._subdivs.size() + 2;
+        for( int j=0; j+1<pointsNum; j++ )
+        {
+            double a[2], b[2];
+            int ty0, ty1, tx0, tx1;
+            segment_rows(edge, j, left_, top_, scale_, tileSize_, tilesNum_, a, b, ty0, ty1);
+            SegmentRef segment = {(uint32_t)i, (uint32_t)j};
+            for( int ty=std::max(ty0, rowFirst_); ty<=std::min(ty1, rowLast_); ty++ )
+            {
+                tile_columns(a[0], a[1], b[0], b[1], reach, tileSize_, tilesNum_, ty, tx0, tx1);
+                for( int tx=tx0; tx<=tx1; tx++ )
+                    binned.push_back(std::make_pair((uint64_t)ty*tilesNum_ + tx, segment));
+            }
+        }
+    }
+    std::stable_sort(binned.begin(), binned.end(),
+                     [](const std::pair<uint64_t, SegmentRef> &a_,
+                        const std::pair<uint64_t, SegmentRef> &b_) {
+        return a_.first < b_.first;
+    });
+
+    tiles_.clear();
+    offsets_.clear();
+    segments_.resize(binned.size());
+    for( size_t k=0; k<binned.size(); k++ )
+    {
+        if( k == 0 || binned[k].first != binned[k-1].first )
+        {
+            tiles_.push_back(binned[k].first);
+            offsets_.push_back(k);
+        }
+        segments_[k] = binned[k].second;
+    }
+    offsets_.push_back(binned.size());
+}
+
+void Rasterizer::bin_nodes(double left_, double top_, double scale_, int tileSize_,
+                           int tilesX_, int tilesY_,
+                           std::vector<size_t> &offsets_, std::vector<uint32_t> &nodes_) const
+{
+    int nodesNum = (int)_nodes.size();
+    double reach = RADIUS*scale_ + 1.0;
+    offsets_.assign((size_t)tilesX_*tilesY_ + 1, 0);
+    for( int pass=0; pass<2; pass++ )
+    {
+        if( pass == 1 )
+        {
+            size_t total = 0, count;
+            for( size_t t=0; t+1<offsets_.size(); t++ )
+            {
+                count = offsets_[t];
+                offsets_[t] = total;
+                total += count;
+            }
+            offsets_.back() = total;
+            nodes_.resize(total);
+        }
+        std::vector<size_t> next(offsets_.begin(), offsets_.end()-1);
+        for( int i=0; i<nodesNum; i++ )
+        {
+            double x = (_nodes[i]._pos.x()-left_)*scale_, y = (top_-_nodes[i]._pos.y())*scale_;
+            int tx0 = std::max(0, (int)std::floor((x - reach) / tileSize_));
+            int tx1 = std::min(tilesX_-1, (int)std::floor((x + reach) / tileSize_));
+            int ty0 = std::max(0, (int)std::floor((y - reach) / tileSize_));
+            int ty1 = std::min(tilesY_-1, (int)std::floor((y + reach) / tileSize_));
+            for( int ty=ty0; ty<=ty1; ty++ )
+                for( int tx=tx0; tx<=tx1; tx++ )
+                {
+                    size_t tile = (size_t)ty*tilesX_ + tx;
+                    if( pass == 0 )
+                        offsets_[tile]++;
+                    else
+                        nodes_[next[tile]++] = (uint32_t)i;
+                }
+        }
+    }
+}
+
+void Rasterizer::draw_edges(const SegmentRef *segments_, size_t count_,
+                            double left_, double top_, double scale_, int width_, int height_,
+                            float *transmittance_, float *density_, float *coverage_) const
+{
+    // covered pixels of the current edge are rows[2y]..rows[2y+1] in row y
+    std::vector<int> rows(2*height_);
+    for( int y=0; y<height_; y++ )
+    {
+        rows[2*y] = width_;
+        rows[2*y+1] = -1;
+    }
+
+    size_t s = 0;
+    while( s < count_ )
+    {
+        // cover the segments of a single edge, then accumulate its coverage once
+        uint32_t e = segments_[s]._edge;
+        const Edge &edge = _edges[e];
+        double halfWidth = 0.5*edge.stroke_width();
+        for( ; s<count_ && segments_[s]._edge == e; s++ )
+        {
+            const meerkat::mk_vector2 &a = point(edge, segments_[s]._index);
+            const meerkat::mk_vector2 &b = point(edge, segments_[s]._index+1);
+            cover_segment((a.x()-left_)*scale_, (top_-a.y())*scale_,
+                          (b.x()-left_)*scale_, (top_-b.y())*scale_,
+                          halfWidth, width_, height_, coverage_, &rows[0]);
+        }
+        for( int y=0; y<height_; y++ )
+        {
+            int row = y*width_;
+            for( int x=rows[2*y]; x<=rows[2*y+1]; x++ )
+            {
+                float c = coverage_[row+x];
+                transmittance_[row+x] *= 1.0f - _alpha*c;
+                density_[row+x] += c;
+                coverage_[row+x] = 0.0f;
+            }
+            rows[2*y] = width_;
+            rows[2*y+1] = -1;
+        }
+    }
+}
+
+void Rasterizer::draw_nodes(const uint32_t *nodes_, size_t count_,
+                            double left_, double top_, double scale_, int width_, int height_,
+                            float *rgb_) const
+{
+    static const float NODE_COLOR[3] = RASTER_NODE_COLOR;
+    static const float ISOLATED_NODE_COLOR[3] = RASTER_ISOLATED_NODE_COLOR;
+    double radius = RADIUS*scale_;
+    for( size_t n=0; n<count_; n++ )
+    {
+        const Node &node = _nodes[nodes_[n]];
+        const float *color = node._degree == 0 ? ISOLATED_NODE_COLOR : NODE_COLOR;
+        double cx = (node._pos.x()-left_)*scale_, cy = (top_-node._pos.y())*scale_;
+        double reach = radius + 0.5;
+        int xMin = std::max(0, (int)std::floor(cx - reach));
+        int xMax = std::min(width_-1, (int)std::floor(cx + reach));
+        int yMin = std::max(0, (int)std::floor(cy - reach));
+        int yMax = std::min(height_-1, (int)std::floor(cy + reach));
+        for( int y=yMin; y<=yMax; y++ )
+            for( int x=xMin; x<=xMax; x++ )
+            {
+                double dx = x + 0.5 - cx, dy = y + 0.5 - cy;
+                float c = (float)std::min(1.0, reach - std::sqrt(dx*dx + dy*dy));
+                if( c <= 0.0f )
+                    continue;
+                float *p = rgb_ + 3*(y*width_ + x);
+                for( int k=0; k<3; k++ )
+                    p[k] += c * (color[k] - p[k]);
+            }
+    }
+}
+
+void Rasterizer::render(const meerkat::mk_vector2 &bottomLeft_, double scale_, int width_, int height_,
+                        bool density_, std::vector<unsigned char> &pixels_) const
+{
+    static const float EDGE_COLOR[3] = RASTER_EDGE_COLOR;
+    int tilesX = (width_ + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    int tilesY = (height_ + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    int tilesNum = tilesX * tilesY;
+    size_t tileArea = RASTER_TILE_SIZE * RASTER_TILE_SIZE;
+    double left = bottomLeft_.x(), top = bottomLeft_.y() + height_/scale_;
+
+    std::vector<size_t> segmentOffsets, nodeOffsets;
+    std::vector<SegmentRef> segments;
+    std::vector<uint32_t> nodes;
+    bin_segments(left, top, scale_, RASTER_TILE_SIZE, tilesX, tilesY, segmentOffsets, segments);
+    if( !density_ )
+        bin_nodes(left, top, scale_, RASTER_TILE_SIZE, tilesX, tilesY, nodeOffsets, nodes);
+
+    // accumulation buffers are stored tile by tile
+    std::vector<float> transmittance(tilesNum * tileArea, 1.0f);
+    std::vector<float> density(tilesNum * tileArea, 0.0f);
+    float maxDensity = 0.0f;
+    #pragma omp parallel reduction(max: maxDensity)
+    {
+        std::vector<float> coverage(tileArea, 0.0f);
+        #pragma omp for schedule(dynamic)
+        for( int t=0; t<tilesNum; t++ )
+        {
+            double tileLeft = left + (t % tilesX) * RASTER_TILE_SIZE / scale_;
+            double tileTop = top - (t / tilesX) * RASTER_TILE_SIZE / scale_;
+            draw_edges(segments.data() + segmentOffsets[t], segmentOffsets[t+1] - segmentOffsets[t],
+                       tileLeft, tileTop, scale_, RASTER_TILE_SIZE, RASTER_TILE_SIZE,
+                       &transmittance[t*tileArea], &density[t*tileArea], &coverage[0]);
+            for( size_t p=0; p<tileArea; p++ )
+                maxDensity = std::max(maxDensity, density[t*tileArea + p]);
+        }
+    }
+
+    // convert to 8-bit pixels
+    int channels = density_ ? 1 : 3;
+    pixels_.resize((size_t)width_ * height_ * channels);
+    float logMax = std::log1p(maxDensity);
+    #pragma omp parallel
+    {
+        std::vector<float> rgb(3*tileArea);
+        #pragma omp for schedule(dynamic)
+        for( int t=0; t<tilesNum; t++ )
+        {
+            int x0 = (t % tilesX) * RASTER_TILE_SIZE, y0 = (t / tilesX) * RASTER_TILE_SIZE;
+            const float *tr = &transmittance[t*tileArea], *d = &density[t*tileArea];
+            if( density_ )
+            {
+                // dark where edges are dense, on a logarithmic scale
+                for( int y=0; y<RASTER_TILE_SIZE && y0+y<height_; y++ )
+                    for( int x=0; x<RASTER_TILE_SIZE && x0+x<width_; x++ )
+                    {
+                        float v = logMax > 0.0f ? std::log1p(d[y*RASTER_TILE_SIZE+x]) / logMax : 0.0f;
+                        pixels_[(size_t)(y0+y)*width_ + x0+x] = (unsigned char)(255.0f*(1.0f-v) + 0.5f);
+                    }
+                continue;
+            }
+
+            // edges over white background
+            for( size_t p=0; p<tileArea; p++ )
+                for( int k=0; k<3; k++ )
+                    rgb[3*p+k] = EDGE_COLOR[k] + (255.0f - EDGE_COLOR[k]) * tr[p];
+            double tileLeft = left + x0 / scale_;
+            double tileTop = top - y0 / scale_;
+            draw_nodes(nodes.data() + nodeOffsets[t], nodeOffsets[t+1] - nodeOffsets[t],
+                       tileLeft, tileTop, scale_, RASTER_TILE_SIZE, RASTER_TILE_SIZE, &rgb[0]);
+            for( int y=0; y<RASTER_TILE_SIZE && y0+y<height_; y++ )
+                for( int x=0; x<RASTER_TILE_SIZE && x0+x<width_; x++ )
+                    for( int k=0; k<3; k++ )
+                        pixels_[3*((size_t)(y0+y)*width_ + x0+x) + k]
+                                = (unsigned char)(rgb[3*(y*RASTER_TILE_SIZE+x)+k] + 0.5f);
+        }
+    }
+}
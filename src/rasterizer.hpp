@@ -0,0 +1,204 @@
+#ifndef RASTERIZER_HPP
+#define RASTERIZER_HPP
+
+#include <vector>
+#include <stdint.h>
+#include "meerkat_vector2.hpp"
+#include "node.hpp"
+#include "edge.hpp"
+
+#define RASTER_TILE_SIZE 64                     // Size of the tiles rendered by a single thread.
+#define RASTER_EDGE_COLOR {212, 0, 0}           // Color of edges.
+#define RASTER_NODE_COLOR {0, 180, 240}         // Color of nodes with edges.
+#define RASTER_ISOLATED_NODE_COLOR {242, 242, 242}  // Color of nodes without edges.
+
+// Reference to the segment between points index and index+1 of an edge polyline.
+struct SegmentRef
+{
+    uint32_t _edge;
+    uint32_t _index;
+};
+
+// Rasterizer class
+// Renders edges and nodes on the CPU. The image is split into tiles that are rendered
+// in parallel, edge coverage is accumulated in floating point.
+class Rasterizer
+{
+private:
+    const std::vector<Edge> &_edges;
+    const std::vector<Node> &_nodes;
+    float _alpha;                               // Opacity of edges.
+
+    /**
+     * @brief point Returns a point of an edge polyline.
+     * @param edge_  Edge.
+     * @param index_ Index of the point, 0 is the start point.
+     * @return       Point of the polyline.
+     */
+    static const meerkat::mk_vector2 &point(const Edge &edge_, int index_);
+
+    /**
+     * @brief cover_segment Computes the coverage of a segment with round caps in a tile.
+     * Coverage of the pixels is the maximum of the old and new coverage, so joints of a
+     * polyline are not covered twice.
+     * @param x0_        First end point x coordinate in tile pixels.
+     * @param y0_        First end point y coordinate in tile pixels.
+     * @param x1_        Second end point x coordinate in tile pixels.
+     * @param y1_        Second end point y coordinate in tile pixels.
+     * @param halfWidth_ Half line width in pixels.
+     * @param width_     Width of the tile.
+     * @param height_    Height of the tile.
+     * @param coverage_  Coverage of the tile pixels.
+     * @param rows_      Range of covered pixels in each row (first, last), extended.
+     */
+    static void cover_segment(double x0_, double y0_, double x1_, double y1_, double halfWidth_,
+                              int width_, int height_, float *coverage_, int *rows_);
+
+    /**
+     * @brief tile_columns Finds the tiles of a row of tiles that are within reach of a
+     *                     segment.
+     * @param ax_       First end point x coordinate in pixels.
+     * @param ay_       First end point y coordinate in pixels.
+     * @param bx_       Second end point x coordinate in pixels.
+     * @param by_       Second end point y coordinate in pixels.
+     * @param reach_    Reach of the segment in pixels.
+     * @param tileSize_ Size of the tiles in pixels.
+     * @param tilesNum_ Number of tiles along each side.
+     * @param row_      Row of tiles.
+     * @param first_    First column within reach.
+     * @param last_     Last column within reach, less than first_ if there is none.
+     */
+    static void tile_columns(double ax_, double ay_, double bx_, double by_, double reach_,
+                             int tileSize_, int tilesNum_, int row_, int &first_, int &last_);
+
+    /**
+     * @brief segment_rows Finds the rows of tiles that are within reach of a segment.
+     * @param edge_     Edge.
+     * @param index_    Index of the segment.
+     * @param left_     Left side of the grid in network coordinates.
+     * @param top_      Top side of the grid in network coordinates.
+     * @param scale_    Pixels per network unit.
+     * @param tileSize_ Size of the tiles in pixels.
+     * @param tilesNum_ Number of tiles along each side.
+     * @param a_        First end point in pixels (x, y).
+     * @param b_        Second end point in pixels (x, y).
+     * @param first_    First row within reach.
+     * @param last_     Last row within reach, less than first_ if there is none.
+     */
+    static void segment_rows(const Edge &edge_, int index_, double left_, double top_,
+                             double scale_, int tileSize_, int tilesNum_,
+                             double *a_, double *b_, int &first_, int &last_);
+
+public:
+    /**
+     * @brief Rasterizer Constructor.
+     * @param edges_ Edges to render.
+     * @param nodes_ Nodes to render.
+     * @param alpha_ Opacity of edges.
+     */
+    Rasterizer(const std::vector<Edge> &edges_, const std::vector<Node> &nodes_, double alpha_);
+
+    /**
+     * @brief bin_segments Bins the edge segments into a grid of tiles.
+     * Segments are listed in tile order, within a tile in edge order.
+     * @param left_     Left side of the grid in network coordinates.
+     * @param top_      Top side of the grid in network coordinates.
+     * @param scale_    Pixels per network unit.
+     * @param tileSize_ Size of the tiles in pixels.
+     * @param tilesX_   Number of tiles horizontally.
+     * @param tilesY_   Number of tiles vertically.
+     * @param offsets_  Start of the segments of each tile, and the end of the last one.
+     * @param segments_ Segments of the tiles.
+     */
+    void bin_segments(double left_, double top_, double scale_, int tileSize_,
+                      int tilesX_, int tilesY_,
+                      std::vector<size_t> &offsets_, std::vector<SegmentRef> &segments_) const;
+
+    /**
+     * @brief count_segments_sparse Counts the segments overlapping the tiles of each row
+     * of a square grid that is too large to be stored.
+     * @param left_     Left side of the grid in network coordinates.
+     * @param top_      Top side of the grid in network coordinates.
+     * @param scale_    Pixels per network unit.
+     * @param tileSize_ Size of the tiles in pixels.
+     * @param tilesNum_ Number of tiles along each side.
+     * @param counts_   Number of segment and tile pairs in each row of tiles.
+     */
+    void count_segments_sparse(double left_, double top_, double scale_, int tileSize_,
+                               int tilesNum_, std::vector<size_t> &counts_) const;
+
+    /**
+     * @brief bin_segments_sparse Bins the edge segments into the tiles of a band of rows
+     * of a square grid that is too large to be stored, only tiles overlapped by segments
+     * are listed. Segments are listed in tile order, within a tile in edge order.
+     * @param left_     Left side of the grid in network coordinates.
+     * @param top_      Top side of the grid in network coordinates.
+     * @param scale_    Pixels per network unit.
+     * @param tileSize_ Size of the tiles in pixels.
+     * @param tilesNum_ Number of tiles along each side.
+     * @param rowFirst_ First row of the band.
+     * @param rowLast_  Last row of the band.
+     * @param tiles_    Overlapped tiles in increasing order, indexed row by row.
+     * @param offsets_  Start of the segments of each listed tile, and the end of the last one.
+     * @param segments_ Segments of the tiles.
+     */
+    void bin_segments_sparse(double left_, double top_, double scale_, int tileSize_,
+                             int tilesNum_, int rowFirst_, int rowLast_,
+                             std::vector<uint64_t> &tiles_, std::vector<size_t> &offsets_,
+                             std::vector<SegmentRef> &segments_) const;
+
+    /**
+     * @brief bin_nodes Bins the nodes into a grid of tiles.
+     * Parameters are the same as for bin_segments.
+     */
+    void bin_nodes(double left_, double top_, double scale_, int tileSize_,
+                   int tilesX_, int tilesY_,
+                   std::vector<size_t> &offsets_, std::vector<uint32_t> &nodes_) const;
+
+    /**
+     * @brief draw_edges Accumulates edges in a tile.
+     * @param segments_      Segments overlapping the tile, in edge order.
+     * @param count_         Number of segments.
+     * @param left_          Left side of the tile in network coordinates.
+     * @param top_           Top side of the tile in network coordinates.
+     * @param scale_         Pixels per network unit.
+     * @param width_         Width of the tile.
+     * @param height_        Height of the tile.
+     * @param transmittance_ Product of (1 - edge opacity * coverage), multiplied in place.
+     * @param density_       Sum of edge coverage, added to in place.
+     * @param coverage_      Zero filled scratch buffer of the tile size, left zero filled.
+     */
+    void draw_edges(const SegmentRef *segments_, size_t count_,
+                    double left_, double top_, double scale_, int width_, int height_,
+                    float *transmittance_, float *density_, float *coverage_) const;
+
+    /**
+     * @brief draw_nodes Draws nodes as opaque disks over a tile.
+     * @param nodes_  Nodes overlapping the tile.
+     * @param count_  Number of nodes.
+     * @param left_   Left side of the tile in network coordinates.
+     * @param top_    Top side of the tile in network coordinates.
+     * @param scale_  Pixels per network unit.
+     * @param width_  Width of the tile.
+     * @param height_ Height of the tile.
+     * @param rgb_    Colors of the tile pixels (0..255), blended in place.
+     */
+    void draw_nodes(const uint32_t *nodes_, size_t count_,
+                    double left_, double top_, double scale_, int width_, int height_,
+                    float *rgb_) const;
+
+    /**
+     * @brief render Renders the network into an image.
+     * @param bottomLeft_ Bottom left corner of the image in network coordinates.
+     * @param scale_      Pixels per network unit.
+     * @param width_      Width of the image.
+     * @param height_     Height of the image.
+     * @param density_    If true, a gray density map of the edges is rendered (one channel),
+     *                    otherwise the edges and nodes are drawn in color (three channels).
+     * @param pixels_     Pixels of the image, top row first.
+     */
+    void render(const meerkat::mk_vector2 &bottomLeft_, double scale_, int width_, int height_,
+                bool density_, std::vector<unsigned char> &pixels_) const;
+};
+
+#endif // RASTERIZER_HPP
@@ -0,0 +1,128 @@
+#include "renderer.hpp"
+#include <map>
+
+Renderer::Renderer()
+{
+    _edgeBuffer = 0;
+    _nodeBuffer = 0;
+    _nodeColorBuffer = 0;
+    _nodeVertices = 0;
+    _edgeOpacity = 1.0f;
+}
+
+void Renderer::set_network(const Graph &graph_)
+{
+    glGenBuffers( 1, &_edgeBuffer );
+    glGenBuffers( 1, &_nodeBuffer );
+    glGenBuffers( 1, &_nodeColorBuffer );
+    _edgeOpacity = (float)graph_.edge_opacity();
+
+    // group edges by rounded line width
+    const std::vector<Edge> &edges = graph_.edges();
+    std::map<long, int> buckets;
+    _edgeBuckets.resize(edges.size());
+    for( size_t i=0; i<edges.size(); i++ )
+    {
+        long step = lround(edges[i]._width / RENDER_WIDTH_STEP);
+        std::map<long, int>::iterator it = buckets.find(step);
+        if( it == buckets.end() )
+        {
+            it = buckets.insert(std::make_pair(step, (int)_lineWidths.size())).first;
+            _lineWidths.push_back((float)(std::max(step, 1L) * RENDER_WIDTH_STEP));
+        }
+        _edgeBuckets[i] = it->second;
+    }
+    _firsts.assign(_lineWidths.size(), std::vector<GLint>());
+    _counts.assign(_lineWidths.size(), std::vector<GLsizei>());
+
+    // nodes are fans of triangles around their centers
+    const std::vector<Node> &nodes = graph_.nodes();
+    std::vector<float> vertices;
+    std::vector<unsigned char> colors;
+    vertices.reserve(nodes.size() * NUM_SEGMENTS * 6);
+    colors.reserve(nodes.size() * NUM_SEGMENTS * 9);
+    for( size_t i=0; i<nodes.size(); i++ )
+    {
+        unsigned char r = 0, g = 180, b = 240;
+        if( nodes[i]._degree == 0 )
+            r = g = b = 242;
+        double x = RADIUS, y = 0.0, t;
+        double cx = nodes[i]._pos.x(), cy = nodes[i]._pos.y();
+        for( int j=0; j<NUM_SEGMENTS; j++ )
+        {
+            vertices.push_back((float)cx);
+            vertices.push_back((float)cy);
+            vertices.push_back((float)(cx + x));
+            vertices.push_back((float)(cy + y));
+            t = x;
+            x = COS_THETA * x - SIN_THETA * y;
+            y = SIN_THETA * t + COS_THETA * y;
+            vertices.push_back((float)(cx + x));
+            vertices.push_back((float)(cy + y));
+            for( int k=0; k<3; k++ )
+            {
+                colors.push_back(r);
+                colors.push_back(g);
+                colors.push_back(b);
+            }
+        }
+    }
+    _nodeVertices = (int)(vertices.size() / 2);
+    glBindBuffer( GL_ARRAY_BUFFER, _nodeBuffer );
+    glBufferData( GL_ARRAY_BUFFER, vertices.size()*sizeof(float), vertices.data(), GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, _nodeColorBuffer );
+    glBufferData( GL_ARRAY_BUFFER, colors.size(), colors.data(), GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void Renderer::update(const std::vector<float> &points_, const std::vector<int> &counts_)
+{
+    for( size_t b=0; b<_firsts.size(); b++ )
+    {
+        _firsts[b].clear();
+        _counts[b].clear();
+    }
+    GLint first = 0;
+    for( size_t i=0; i<counts_.size(); i++ )
+    {
+        _firsts[_edgeBuckets[i]].push_back(first);
+        _counts[_edgeBuckets[i]].push_back(counts_[i]);
+        first += counts_[i];
+    }
+
+    // orphan the old storage so the driver does not wait for pending draws
+    glBindBuffer( GL_ARRAY_BUFFER, _edgeBuffer );
+    glBufferData( GL_ARRAY_BUFFER, points_.size()*sizeof(float), NULL, GL_STREAM_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, points_.size()*sizeof(float), points_.data() );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void Renderer::draw()
+{
+    glEnableClientState( GL_VERTEX_ARRAY );
+
+    // edges
+    glBindBuffer( GL_ARRAY_BUFFER, _edgeBuffer );
+    glVertexPointer( 2, GL_FLOAT, 0, 0 );
+    glColor4f( 212./255., 0./255., 0./255., _edgeOpacity );
+    for( size_t b=0; b<_lineWidths.size(); b++ )
+    {
+        if( _firsts[b].empty() )
+            continue;
+        glLineWidth( _lineWidths[b] );
+        glMultiDrawArrays( GL_LINE_STRIP, _firsts[b].data(), _counts[b].data(),
+                           (GLsizei)_firsts[b].size() );
+    }
+
+    // nodes
+    glEnableClientState( GL_COLOR_ARRAY );
+    glBindBuffer( GL_ARRAY_BUFFER, _nodeColorBuffer );
+    glColorPointer( 3, GL_UNSIGNED_BYTE, 0, 0 );
+    glBindBuffer( GL_ARRAY_BUFFER, _nodeBuffer );
+    glVertexPointer( 2, GL_FLOAT, 0, 0 );
+    glDrawArrays( GL_TRIANGLES, 0, _nodeVertices );
+    glDisableClientState( GL_COLOR_ARRAY );
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glDisableClientState( GL_VERTEX_ARRAY );
+}
@@ -0,0 +1,57 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include <vector>
+#ifdef __APPLE__
+#include "GLUT/glut.h"
+#else
+#define GL_GLEXT_PROTOTYPES
+#include "GL/glut.h"
+#endif
+#include "graph.hpp"
+
+#define RENDER_WIDTH_STEP 0.125         // Line widths are rounded to multiples of this (pixels).
+
+// Renderer class
+// Draws the network from vertex buffers: edges are line strips streamed once per
+// update and drawn with one call per line width, nodes are a static triangle buffer.
+class Renderer
+{
+private:
+    GLuint _edgeBuffer;                                 // Points of the edge polylines.
+    GLuint _nodeBuffer;                                 // Triangles of the nodes.
+    GLuint _nodeColorBuffer;                            // Colors of the node triangles.
+    int _nodeVertices;                                  // Number of node vertices.
+    float _edgeOpacity;                                 // Opacity of edges.
+    std::vector<float> _lineWidths;                     // Line width of each bucket.
+    std::vector<int> _edgeBuckets;                      // Width bucket of each edge.
+    std::vector<std::vector<GLint> > _firsts;           // First point of the edges in each bucket.
+    std::vector<std::vector<GLsizei> > _counts;         // Number of points of the edges in each bucket.
+
+public:
+    /**
+     * @brief Renderer Constructor.
+     */
+    Renderer();
+
+    /**
+     * @brief set_network Creates the buffers and uploads the nodes.
+     * Needs a current GL context.
+     * @param graph_ Network to draw.
+     */
+    void set_network(const Graph &graph_);
+
+    /**
+     * @brief update Uploads the points of the edge polylines.
+     * @param points_ Coordinates of the points, in edge order.
+     * @param counts_ Number of points of each edge.
+     */
+    void update(const std::vector<float> &points_, const std::vector<int> &counts_);
+
+    /**
+     * @brief draw Draws edges and nodes.
+     */
+    void draw();
+};
+
+#endif // RENDERER_HPP
@@ -0,0 +1,55 @@
+#ifndef SERVE_FORMAT_HPP
+#define SERVE_FORMAT_HPP
+
+#include <stdint.h>
+#include "graph_format.hpp"
+
+// Messages of 'fdeb serve' over a Unix domain socket (native byte order). A client sends
+// any number of requests on a connection, each is answered before the next is read:
+//   request:  ServeRequestHeader
+//             double      coordinates[2*nodesNum]    x0 y0 x1 y1 ...
+//             EdgeRecord  edges[edgesNum]
+//   response: ServeResponseHeader
+//             char        body[size]                 binary polylines (see polyline_format.hpp)
+//                                                    on success, error message otherwise
+// Malformed requests are answered with an error and the connection is closed.
+
+#define SERVE_REQUEST_MAGIC "FDEBJOB1"
+#define SERVE_RESPONSE_MAGIC "FDEBRES1"
+#define SERVE_STATUS_OK 0
+#define SERVE_STATUS_INVALID_REQUEST 1
+#define SERVE_STATUS_INVALID_GRAPH 2
+
+// Header of a request, the parameters are those of the command line options
+struct ServeRequestHeader
+{
+    char magic[8];                  // SERVE_REQUEST_MAGIC without terminating zero.
+    uint32_t byteOrder;             // GRAPH_FILE_BYTE_ORDER as written by the client.
+    uint32_t scalarSize;            // Size of the coordinates in the response (4 or 8).
+    double K;                       // Edge stiffness.
+    double compat;                  // Compatibility threshold.
+    double sigma;                   // Smoothing width.
+    double S;                       // Initial displacement.
+    double epsilon;                 // Lowest interaction distance.
+    double gravitationCenter[2];    // Gravitation center.
+    double gravitationExponent;     // Gravitation exponent.
+    double edgeWeight;              // Edge weight threshold, unset if not positive.
+    double edgePercentage;          // Percentage of edges kept, unset if not positive.
+    int32_t cycles;                 // Number of cycles.
+    int32_t I;                      // Initial number of iterations.
+    int32_t gravitation;            // Non-zero to turn gravitation on.
+    int32_t mergeEdges;             // Non-zero to merge parallel and anti-parallel edges.
+    uint64_t nodesNum;              // Number of nodes.
+    uint64_t edgesNum;              // Number of edges.
+};
+
+// Header of a response
+struct ServeResponseHeader
+{
+    char magic[8];                  // SERVE_RESPONSE_MAGIC without terminating zero.
+    int32_t status;                 // One of the SERVE_STATUS_* values.
+    uint32_t reserved;              // Padding, zero.
+    uint64_t size;                  // Size of the body in bytes.
+};
+
+#endif // SERVE_FORMAT_HPP
@@ -0,0 +1,352 @@
+#include "server.hpp"
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "worker_pool.hpp"
+
+/**
+ * @brief read_fully Reads a given number of bytes from a socket.
+ * @param socket_ Socket.
+ * @param buffer_ Destination.
+ * @param size_   Number of bytes to read.
+ * @return        Number of bytes read, less than size_ only if the connection is closed
+ *                or broken.
+ */
+static size_t read_fully(int socket_, char *buffer_, size_t size_)
+{
+    size_t done = 0;
+    while( done < size_ )
+    {
+        ssize_t n = read(socket_, buffer_ + done, size_ - done);
+        if( n < 0 && errno == EINTR )
+            continue;
+        if( n <= 0 )
+            break;
+        done += (size_t)n;
+    }
+    return done;
+}
+
+/**
+ * @brief write_fully Writes a given number of bytes to a socket.
+ * @param socket_ Socket.
+ * @param buffer_ Source.
+ * @param size_   Number of bytes to write.
+ * @return        True if all bytes are written.
+ */
+static bool write_fully(int socket_, const char *buffer_, size_t size_)
+{
+    size_t done = 0;
+    while( done < size_ )
+    {
+        ssize_t n = write(socket_, buffer_ + done, size_ - done);
+        if( n < 0 && errno == EINTR )
+            continue;
+        if( n <= 0 )
+            return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief hash_bytes Extends an FNV-1a hash with a sequence of bytes.
+ * @param hash_  Hash so far.
+ * @param data_  Bytes.
+ * @param size_  Number of bytes.
+ * @return       Extended hash.
+ */
+static uint64_t hash_bytes(uint64_t hash_, const void *data_, size_t size_)
+{
+    const unsigned char *p = (const unsigned char *)data_;
+    for( size_t i=0; i<size_; i++ )
+    {
+        hash_ ^= p[i];
+        hash_ *= 1099511628211ull;
+    }
+    return hash_;
+}
+
+Server::Server(std::string socketPath_, int workersNum_)
+{
+    _log.tag("Server");
+    _socketPath = socketPath_;
+    _workersNum = std::max(1, workersNum_);
+    _listener = -1;
+    _wakeup[0] = _wakeup[1] = -1;
+}
+
+std::shared_ptr<const CompatibilityLists> Server::find_lists(uint64_t key_)
+{
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    std::unordered_map<uint64_t, std::shared_ptr<const CompatibilityLists> >::iterator it
+            = _cache.find(key_);
+    if( it == _cache.end() )
+        return std::shared_ptr<const CompatibilityLists>();
+    _cacheOrder.remove(key_);
+    _cacheOrder.push_front(key_);
+    return it->second;
+}
+
+void Server::cache_lists(uint64_t key_, std::shared_ptr<const CompatibilityLists> lists_)
+{
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    if( _cache.find(key_) != _cache.end() )
+        return;
+    _cache[key_] = lists_;
+    _cacheOrder.push_front(key_);
+    if( (int)_cacheOrder.size() > SERVE_CACHE_SIZE )
+    {
+        _cache.erase(_cacheOrder.back());
+        _cacheOrder.pop_back();
+    }
+}
+
+int Server::bundle(const ServeRequestHeader &header_, std::vector<char> &body_, Graph &graph_)
+{
+    graph_.set_algorithm_params(header_.K, header_.cycles, header_.I, header_.compat, header_.sigma);
+    graph_.set_network_params(header_.edgeWeight, header_.edgePercentage, header_.mergeEdges != 0);
+    graph_.set_physics_params(header_.S, header_.epsilon,
+                              meerkat::mk_vector2(header_.gravitationCenter[0],
+                                                  header_.gravitationCenter[1]),
+                              header_.gravitationExponent);
+    graph_.enable_gravitation(header_.gravitation != 0);
+
+    // compatibility depends on the network, its filters and the threshold
+    uint64_t key = hash_bytes(14695981039346656037ull, body_.data(), body_.size());
+    key = hash_bytes(key, &header_.compat, sizeof(header_.compat));
+    key = hash_bytes(key, &header_.edgeWeight, sizeof(header_.edgeWeight));
+    key = hash_bytes(key, &header_.edgePercentage, sizeof(header_.edgePercentage));
+    key = hash_bytes(key, &header_.mergeEdges, sizeof(header_.mergeEdges));
+    std::shared_ptr<const CompatibilityLists> lists = find_lists(key);
+
+    const double *coords = (const double *)body_.data();
+    const EdgeRecord *records = (const EdgeRecord *)(coords + 2*header_.nodesNum);
+    if( !graph_.load(coords, (uint32_t)header_.nodesNum, records, (uint32_t)header_.edgesNum,
+                     !lists) )
+    {
+        const char *message = "invalid graph";
+        body_.assign(message, message + strlen(message));
+        return SERVE_STATUS_INVALID_GRAPH;
+    }
+    if( lists && !graph_.set_compatibility_lists(lists) )
+    {
+        graph_.build_compatibility_lists();
+        lists.reset();
+    }
+    if( !lists )
+        cache_lists(key, graph_.compatibility_lists());
+
+    graph_.run();
+    graph_.smooth();
+    PolylineFileHeader polylines;
+    body_.resize(graph_.polyline_header(polylines, header_.scalarSize));
+    graph_.fill_polylines(body_.data(), polylines);
+    return SERVE_STATUS_OK;
+}
+
+bool Server::serve(int connection_, Graph &graph_, std::vector<char> &body_)
+{
+    ServeRequestHeader request;
+    ServeResponseHeader response;
+    memcpy(response.magic, SERVE_RESPONSE_MAGIC, 8);
+    response.reserved = 0;
+    if( read_fully(connection_, (char *)&request, sizeof(request)) != sizeof(request) )
+        return false;
+
+    // check header before allocating the body
+    uint64_t bodySize = 2*request.nodesNum*sizeof(double) + request.edgesNum*sizeof(EdgeRecord);
+    bool valid = memcmp(request.magic, SERVE_REQUEST_MAGIC, 8) == 0
+            && request.byteOrder == GRAPH_FILE_BYTE_ORDER
+            && (request.scalarSize == 4 || request.scalarSize == 8)
+            && request.nodesNum <= 0xffffffffull && request.edgesNum <= 0x7fffffffull
+            && bodySize <= SERVE_MAX_REQUEST_BYTES
+            && request.cycles >= 0 && request.cycles <= MAX_CYCLES && request.I >= 0;
+    if( valid )
+    {
+        body_.resize(bodySize);
+        if( read_fully(connection_, body_.data(), bodySize) != bodySize )
+            return false;
+        response.status = bundle(request, body_, graph_);
+    }
+    else
+    {
+        const char *message = "invalid request header";
+        body_.assign(message, message + strlen(message));
+        response.status = SERVE_STATUS_INVALID_REQUEST;
+    }
+
+    response.size = body_.size();
+    return write_fully(connection_, (const char *)&response, sizeof(response))
+            && write_fully(connection_, body_.data(), body_.size())
+            && valid;
+}
+
+void Server::queue(int connection_)
+{
+    std::lock_guard<std::mutex> lock(_connectionsMutex);
+    _connections.push_back(connection_);
+    _connectionsReady.notify_one();
+}
+
+void Server::release(int connection_)
+{
+    std::lock_guard<std::mutex> lock(_idleMutex);
+    _idle.push_back(connection_);
+    // the pipe is non-blocking, a full pipe already wakes up the polling
+    char wake = 0;
+    ssize_t written = write(_wakeup[1], &wake, 1);
+    (void)written;
+}
+
+void Server::work(Graph &graph_)
+{
+    std::vector<char> body;
+    while( true )
+    {
+        int connection;
+        {
+            std::unique_lock<std::mutex> lock(_connectionsMutex);
+            _connectionsReady.wait(lock, [this] { return !_connections.empty(); });
+            connection = _connections.front();
+            _connections.pop_front();
+        }
+        if( serve(connection, graph_, body) )
+            release(connection);
+        else
+            close(connection);
+    }
+}
+
+bool Server::run()
+{
+    // a closed client must not terminate the server
+    signal(SIGPIPE, SIG_IGN);
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if( _socketPath.size() >= sizeof(address.sun_path) )
+    {
+        _log.e("run", "socket path is too long");
+        return false;
+    }
+    strcpy(address.sun_path, _socketPath.c_str());
+
+    // remove a socket left by a previous server, unless that server still listens on it
+    struct stat status;
+    if( stat(_socketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode) )
+    {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool refused = probe >= 0
+                && connect(probe, (struct sockaddr *)&address, sizeof(address)) != 0
+                && errno == ECONNREFUSED;
+        if( probe >= 0 )
+            close(probe);
+        if( !refused )
+        {
+            _log.e("run", "socket '%s' is in use", _socketPath.c_str());
+            return false;
+        }
+        unlink(_socketPath.c_str());
+    }
+    _listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( _listener < 0
+            || bind(_listener, (struct sockaddr *)&address, sizeof(address)) != 0
+            || listen(_listener, SERVE_BACKLOG) != 0 )
+    {
+        _log.e("run", "could not listen on '%s': %s", _socketPath.c_str(), strerror(errno));
+        if( _listener >= 0 )
+            close(_listener);
+        _listener = -1;
+        return false;
+    }
+
+    if( pipe(_wakeup) != 0 )
+    {
+        _log.e("run", "could not create wakeup pipe: %s", strerror(errno));
+        close(_listener);
+        _listener = -1;
+        return false;
+    }
+    fcntl(_wakeup[0], F_SETFL, O_NONBLOCK);
+    fcntl(_wakeup[1], F_SETFL, O_NONBLOCK);
+
+    WorkerPool pool(_workersNum);
+    _log.i("run", "listening on '%s' with %d workers of %d threads",
+           _socketPath.c_str(), pool.workers_num(), pool.threads_num());
+    pool.start([this](Graph &graph_) { work(graph_); });
+
+    // a stalled client is dropped instead of blocking its worker
+    struct timeval timeout;
+    timeout.tv_sec = SERVE_TIMEOUT;
+    timeout.tv_usec = 0;
+    std::vector<struct pollfd> polled;
+    bool exhausted = false;
+    while( true )
+    {
+        polled.clear();
+        polled.push_back({_listener, POLLIN, 0});
+        polled.push_back({_wakeup[0], POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            for( size_t k=0; k<_idle.size(); k++ )
+                polled.push_back({_idle[k], POLLIN, 0});
+        }
+        if( poll(polled.data(), polled.size(), -1) < 0 )
+        {
+            if( errno != EINTR )
+                _log.w("run", "could not poll connections: %s", strerror(errno));
+            continue;
+        }
+        if( polled[1].revents != 0 )
+        {
+            char signals[64];
+            while( read(_wakeup[0], signals, sizeof(signals)) > 0 );
+        }
+
+        // connections with a request, or closed by the client, go to the workers
+        for( size_t k=2; k<polled.size(); k++ )
+        {
+            if( polled[k].revents == 0 )
+                continue;
+            {
+                std::lock_guard<std::mutex> lock(_idleMutex);
+                _idle.erase(std::find(_idle.begin(), _idle.end(), polled[k].fd));
+            }
+            queue(polled[k].fd);
+        }
+
+        if( polled[0].revents == 0 )
+            continue;
+        int connection = accept(_listener, NULL, NULL);
+        if( connection < 0 )
+        {
+            // the listener stays readable until a descriptor is freed
+            if( errno == EMFILE || errno == ENFILE )
+            {
+                if( !exhausted )
+                    _log.w("run", "could not accept connection: %s", strerror(errno));
+                exhausted = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(SERVE_ACCEPT_BACKOFF));
+            }
+            else if( errno != EINTR && errno != ECONNABORTED )
+                _log.w("run", "could not accept connection: %s", strerror(errno));
+            continue;
+        }
+        exhausted = false;
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        std::lock_guard<std::mutex> lock(_idleMutex);
+        _idle.push_back(connection);
+    }
+}
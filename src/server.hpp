@@ -0,0 +1,114 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <unordered_map>
+#include "meerkat_logger.hpp"
+#include "graph.hpp"
+#include "serve_format.hpp"
+
+#define SERVE_MAX_REQUEST_BYTES (1ull << 32)    // Largest accepted request body.
+#define SERVE_CACHE_SIZE 64                     // Number of networks with cached compatibility lists.
+#define SERVE_BACKLOG 64                        // Pending connections of the socket.
+#define SERVE_TIMEOUT 30                        // Seconds a request or response may stall.
+#define SERVE_ACCEPT_BACKOFF 100                // Milliseconds to wait when out of file descriptors.
+
+// Server class
+// Bundles networks sent over a Unix domain socket. Requests are served by a fixed pool
+// of workers, each keeping a graph whose buffers are reused between requests. A worker
+// answers a single request and hands the connection back, idle connections are polled
+// and queued again once their next request arrives.
+// Compatibility lists are cached by a hash of the network and the parameters they
+// depend on, and shared by the workers.
+class Server
+{
+private:
+    std::string _socketPath;
+    int _workersNum;
+    int _listener;                                  // Listening socket.
+    std::deque<int> _connections;                   // Connections with a request waiting for a worker.
+    std::mutex _connectionsMutex;
+    std::condition_variable _connectionsReady;
+    std::vector<int> _idle;                         // Connections waiting for their next request.
+    std::mutex _idleMutex;
+    int _wakeup[2];                                 // Pipe waking up the polling of idle connections.
+    std::unordered_map<uint64_t, std::shared_ptr<const CompatibilityLists> > _cache;
+    std::list<uint64_t> _cacheOrder;                // Cached keys, most recently used first.
+    std::mutex _cacheMutex;
+    meerkat::mk_log _log;
+
+    /**
+     * @brief work Serves connections until the process exits.
+     * @param graph_ Graph of the worker, reused by all jobs.
+     */
+    void work(Graph &graph_);
+
+    /**
+     * @brief serve Answers the next request of a connection.
+     * @param connection_ Connected socket.
+     * @param graph_      Graph of the worker.
+     * @param body_       Buffer of the worker for request and response bodies.
+     * @return            False if the connection is closed, broken, timed out or sent an
+     *                    invalid request.
+     */
+    bool serve(int connection_, Graph &graph_, std::vector<char> &body_);
+
+    /**
+     * @brief queue Queues a connection with a request for the workers.
+     * @param connection_ Connected socket.
+     */
+    void queue(int connection_);
+
+    /**
+     * @brief release Hands a served connection back to be polled for its next request.
+     * @param connection_ Connected socket.
+     */
+    void release(int connection_);
+
+    /**
+     * @brief bundle Bundles the network of a request.
+     * @param header_ Request header.
+     * @param body_   Request body, replaced by the response body.
+     * @param graph_  Graph of the worker.
+     * @return        One of the SERVE_STATUS_* values.
+     */
+    int bundle(const ServeRequestHeader &header_, std::vector<char> &body_, Graph &graph_);
+
+    /**
+     * @brief find_lists Looks up cached compatibility lists.
+     * @param key_ Hash of the network.
+     * @return     Lists or NULL if not cached.
+     */
+    std::shared_ptr<const CompatibilityLists> find_lists(uint64_t key_);
+
+    /**
+     * @brief cache_lists Caches compatibility lists, dropping the least recently used ones.
+     * @param key_   Hash of the network.
+     * @param lists_ Lists to cache.
+     */
+    void cache_lists(uint64_t key_, std::shared_ptr<const CompatibilityLists> lists_);
+
+public:
+    /**
+     * @brief Server Constructor.
+     * @param socketPath_ Path of the Unix domain socket.
+     * @param workersNum_ Number of workers.
+     */
+    Server(std::string socketPath_, int workersNum_);
+
+    /**
+     * @brief run Listens on the socket and serves connections, returns only if the
+     *            socket could not be set up.
+     * OpenMP threads are divided among the workers.
+     * @return False if the socket could not be created, bound or listened on.
+     */
+    bool run();
+};
+
+#endif // SERVER_HPP
@@ -0,0 +1,167 @@
+#include "sweep.hpp"
+#include <sstream>
+#include "worker_pool.hpp"
+#include "meerkat_stopwatch.hpp"
+#include "meerkat_table_writer.hpp"
+
+// Parameters that the compatibility lists do not depend on
+static const char *SWEPT_KEYS[] = {"K", "S", "I", "cycles", "sigma", "epsilon",
+                                   "gravitation-center-x", "gravitation-center-y",
+                                   "gravitation-exponent"};
+
+Sweep::Sweep(const Job &base_, std::string output_, int workersNum_)
+{
+    _log.tag("Sweep");
+    _base = base_;
+    // configurations would overwrite each other's checkpoints, and a warm start
+    // would not be copied with the network
+    _base.checkpoint = "";
+    _base.warmStart = "";
+    _output = output_;
+    _workersNum = workersNum_;
+    _nextConfiguration = 0;
+    _network = NULL;
+}
+
+bool Sweep::add_grid(std::string key_, std::string values_)
+{
+    bool swept = false;
+    for( size_t k=0; k<sizeof(SWEPT_KEYS)/sizeof(SWEPT_KEYS[0]); k++ )
+        swept = swept || key_ == SWEPT_KEYS[k];
+    if( !swept )
+    {
+        _log.e("add_grid", "parameter '%s' cannot be swept", key_.c_str());
+        return false;
+    }
+
+    Grid grid;
+    grid.key = key_;
+    std::istringstream tokens(values_);
+    std::string value;
+    Job job;
+    while( std::getline(tokens, value, ',') )
+    {
+        if( !job.set(key_, value) )
+        {
+            _log.e("add_grid", "invalid value '%s' of '%s'", value.c_str(), key_.c_str());
+            return false;
+        }
+        grid.values.push_back(value);
+    }
+    if( grid.values.empty() )
+    {
+        _log.e("add_grid", "no values of '%s'", key_.c_str());
+        return false;
+    }
+    _grids.push_back(grid);
+    return true;
+}
+
+void Sweep::build_configurations()
+{
+    // odometer over the grids, the last grid changes fastest
+    int gridsNum = (int)_grids.size();
+    std::vector<int> indices(gridsNum, 0);
+    _configurations.clear();
+    while( true )
+    {
+        Configuration configuration;
+        configuration.job = _base;
+        // swept values are inserted before the extension
+        std::string suffix;
+        for( int g=0; g<gridsNum; g++ )
+        {
+            const std::string &value = _grids[g].values[indices[g]];
+            configuration.job.set(_grids[g].key, value);
+            configuration.values.push_back(value);
+            suffix += "_" + _grids[g].key + value;
+        }
+        configuration.job.set_output(Job::output_name(_output, suffix));
+        configuration.ok = false;
+        configuration.bundleTime = configuration.writeTime = 0.0;
+        _configurations.push_back(configuration);
+
+        int g = gridsNum-1;
+        while( g >= 0 && ++indices[g] == (int)_grids[g].values.size() )
+            indices[g--] = 0;
+        if( g < 0 )
+            break;
+    }
+}
+
+void Sweep::work(Graph &graph_)
+{
+    int configurationsNum = (int)_configurations.size();
+    for( int c=_nextConfiguration++; c<configurationsNum; c=_nextConfiguration++ )
+    {
+        Configuration &configuration = _configurations[c];
+        configuration.job.configure(graph_);
+        graph_.copy_network(*_network);
+
+        meerkat::mk_stopwatch stopwatch;
+        graph_.run();
+        configuration.bundleTime = stopwatch.seconds();
+
+        stopwatch.restart();
+        configuration.ok = configuration.job.finish(graph_);
+        configuration.writeTime = stopwatch.seconds();
+        if( !configuration.ok )
+            _log.w("work", "configuration %d failed", c);
+    }
+}
+
+int Sweep::run()
+{
+    build_configurations();
+
+    // network and compatibility lists are built once
+    Graph network;
+    _base.configure(network);
+    if( !network.read(_base.nodes, _base.edges, true) )
+        return -1;
+    _network = &network;
+
+    WorkerPool pool(_workersNum);
+    _log.i("run", "running %d configurations with %d workers of %d threads",
+           (int)_configurations.size(), pool.workers_num(), pool.threads_num());
+    _nextConfiguration = 0;
+
+    meerkat::mk_stopwatch stopwatch;
+    pool.start([this](Graph &graph_) { work(graph_); });
+    pool.join();
+    _network = NULL;
+
+    int failedNum = 0;
+    for( size_t c=0; c<_configurations.size(); c++ )
+        failedNum += _configurations[c].ok ? 0 : 1;
+    _log.i("run", "%d configurations are done in %.2lf s, %d failed",
+           (int)_configurations.size(), stopwatch.seconds(), failedNum);
+    return failedNum;
+}
+
+bool Sweep::print_summary(std::string output_)
+{
+    meerkat::mk_table_writer table;
+    std::string header;
+    for( size_t g=0; g<_grids.size(); g++ )
+        header += _grids[g].key + "\t";
+    table.line("%sstatus\tbundle_s\twrite_s", header.c_str());
+    for( size_t c=0; c<_configurations.size(); c++ )
+    {
+        const Configuration &configuration = _configurations[c];
+        std::string values;
+        for( size_t g=0; g<configuration.values.size(); g++ )
+            values += configuration.values[g] + "\t";
+        table.line("%s%s\t%.3lf\t%.3lf", values.c_str(),
+                   configuration.ok ? "ok" : "write error",
+                   configuration.bundleTime, configuration.writeTime);
+    }
+    if( !table.write(output_) )
+    {
+        _log.e("print_summary", "could not write output file");
+        return false;
+    }
+    if( output_ != "" )
+        _log.i("print_summary", "summary is written in '%s'", output_.c_str());
+    return true;
+}
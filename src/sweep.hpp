@@ -0,0 +1,94 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include "meerkat_logger.hpp"
+#include "graph.hpp"
+#include "job.hpp"
+
+// Sweep class
+// Bundles a network with every combination of a set of parameter grids. The network
+// and its compatibility lists are built once, the configurations are run on a fixed
+// pool of workers that copy only the edges and share the lists. Only parameters that
+// the compatibility lists do not depend on can be swept.
+//
+// Output names are the base output name with the swept values inserted before the
+// extension, e.g. out_K0.1_S0.4.json.
+class Sweep
+{
+private:
+    // Values of a swept parameter
+    struct Grid
+    {
+        std::string key;                // Long command line option name.
+        std::vector<std::string> values;
+    };
+
+    // Configuration and its outcome
+    struct Configuration
+    {
+        Job job;
+        std::vector<std::string> values;    // Swept values, in the order of the grids.
+        bool ok;
+        double bundleTime;              // Time of the iterations (s).
+        double writeTime;               // Time of smoothing and writing outputs (s).
+    };
+
+    Job _base;
+    std::string _output;
+    std::vector<Grid> _grids;
+    std::vector<Configuration> _configurations;
+    std::atomic<int> _nextConfiguration;
+    int _workersNum;
+    Graph *_network;                    // Network read once and copied by the workers.
+    meerkat::mk_log _log;
+
+    /**
+     * @brief build_configurations Creates the configurations of all combinations of
+     *                             the grids.
+     */
+    void build_configurations();
+
+    /**
+     * @brief work Runs configurations until all are taken.
+     * @param graph_ Graph of the worker, reused by all configurations.
+     */
+    void work(Graph &graph_);
+
+public:
+    /**
+     * @brief Sweep Constructor.
+     * @param base_       Input and parameters that are not swept.
+     * @param output_     Base output name, the format is chosen by the extension.
+     * @param workersNum_ Number of workers, 0 for one per core.
+     */
+    Sweep(const Job &base_, std::string output_, int workersNum_);
+
+    /**
+     * @brief add_grid Adds a swept parameter.
+     * @param key_    Long command line option name: K, S, I, cycles, sigma, epsilon,
+     *                gravitation-center-x, gravitation-center-y or gravitation-exponent.
+     * @param values_ Comma separated values.
+     * @return        False if the parameter cannot be swept or a value is invalid.
+     */
+    bool add_grid(std::string key_, std::string values_);
+
+    /**
+     * @brief run Reads the network and runs all configurations.
+     * OpenMP threads are divided among the workers.
+     * @return Number of failed configurations, -1 if the network could not be read.
+     */
+    int run();
+
+    /**
+     * @brief print_summary Prints the swept values and timings of the configurations
+     *                      as tab separated values.
+     * @param output_ Name of output file, standard output if empty.
+     * @return        False if the file could not be written.
+     */
+    bool print_summary(std::string output_);
+};
+
+#endif // SWEEP_HPP
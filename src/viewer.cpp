@@ -0,0 +1,135 @@
+#include "viewer.hpp"
+#include <thread>
+#include <atomic>
+#include "renderer.hpp"
+#include "meerkat_triple_buffer.hpp"
+
+// Positions of the edge polylines published to the live view.
+struct Snapshot
+{
+    std::vector<float> points;
+    std::vector<int> counts;
+};
+
+static Graph *gGraph = NULL;
+static std::function<void()> gFinish;
+static Renderer gRenderer;
+static meerkat::mk_triple_buffer<Snapshot> gSnapshots;
+static std::thread gSimulation;
+static std::atomic<bool> gStop(false);
+
+static void init( meerkat::mk_vector2 bottomLeft_,
+                  meerkat::mk_vector2 topRight_ )
+{
+    glClearColor( 1.0, 1.0, 1.0, 1.0 );
+    glMatrixMode( GL_PROJECTION );
+    glLoadIdentity();
+    gluOrtho2D( bottomLeft_.x(), topRight_.x(), bottomLeft_.y(), topRight_.y() );
+    glMatrixMode( GL_MODELVIEW );
+    glLoadIdentity();
+
+    glEnable( GL_LINE_SMOOTH );
+    glHint (GL_LINE_SMOOTH_HINT, GL_NICEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable( GL_BLEND );
+
+    gRenderer.set_network(*gGraph);
+    Snapshot snapshot;
+    gGraph->get_polylines(snapshot.points, snapshot.counts);
+    gRenderer.update(snapshot.points, snapshot.counts);
+}
+
+static void publish( bool force_ )
+{
+    // skip copying while the live view has not taken the previous snapshot
+    if( !force_ && !gSnapshots.is_consumed() )
+        return;
+    gGraph->get_polylines(gSnapshots.back().points, gSnapshots.back().counts);
+    gSnapshots.publish();
+}
+
+static void simulate()
+{
+    do
+    {
+        while( !gStop && gGraph->iterate() > 0 )
+            publish(false);
+        if( gStop )
+            return;
+        gGraph->add_subvisions();
+        publish(false);
+    } while( gGraph->update_cycle() > 0 );
+    gFinish();
+    publish(true);
+}
+
+static void stop()
+{
+    gStop = true;
+    if( gSimulation.joinable() )
+        gSimulation.join();
+}
+
+static void display()
+{
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    gRenderer.draw();
+    glutSwapBuffers();
+    glFlush();
+}
+
+static void keyboard( unsigned char key_, int x_, int y_ )
+{
+    switch( key_ )
+    {
+    case 27:
+        exit(0);
+        break;
+    }
+}
+
+static void timer( int var_ )
+{
+    if( gSnapshots.consume() )
+    {
+        gRenderer.update(gSnapshots.front().points, gSnapshots.front().counts);
+        glutPostRedisplay();
+    }
+    glutTimerFunc( FRAME_INTERVAL, timer, var_ );
+}
+
+void run_viewer(Graph &graph_, std::function<void()> finish_, int *argc_, char **argv_)
+{
+    gGraph = &graph_;
+    gFinish = finish_;
+
+    // Get bounding box
+    meerkat::mk_vector2 bottomLeft, topRight;
+    gGraph->get_bounding_box(bottomLeft, topRight, 20.0);
+    double gWidth = topRight.x() - bottomLeft.x();
+    double gHeight = topRight.y() - bottomLeft.y();
+
+    // Init GLUT
+    int wWidth = VIEWER_SIZE, wHeight = VIEWER_SIZE;
+    if( gWidth > gHeight )
+        wHeight = int(wWidth * gHeight/gWidth);
+    else
+        wWidth = int(wHeight * gWidth/gHeight);
+    glutInit( argc_, argv_ );
+    glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE );
+    glutInitWindowSize( wWidth, wHeight );
+    glutInitWindowPosition( 10, 100 );
+    glutCreateWindow( "fdeb" );
+    init(bottomLeft, topRight);
+
+    // Increase cycle index and enter main loop
+    glutDisplayFunc( display );
+    glutKeyboardFunc( keyboard );
+    glutTimerFunc( FRAME_INTERVAL, timer, 1 );
+
+    // Bundle on a worker thread, the live view only draws published snapshots
+    // and is stopped when GLUT exits the process
+    atexit(stop);
+    gSimulation = std::thread(simulate);
+    glutMainLoop();
+}
@@ -0,0 +1,20 @@
+#ifndef VIEWER_HPP
+#define VIEWER_HPP
+
+#include <functional>
+#include "graph.hpp"
+
+#define VIEWER_SIZE 600                 // Size of the longer side of the window in pixels.
+#define FRAME_INTERVAL 16               // Time between checks for new positions (ms).
+
+/**
+ * @brief run_viewer Bundles the network on a worker thread and shows it in a GLUT
+ *                   window. Does not return, the process exits when the window is closed.
+ * @param graph_  Network with parameters set, already read.
+ * @param finish_ Called on the worker thread after the last cycle.
+ * @param argc_   Command line argument count for GLUT.
+ * @param argv_   Command line arguments for GLUT.
+ */
+void run_viewer(Graph &graph_, std::function<void()> finish_, int *argc_, char **argv_);
+
+#endif // VIEWER_HPP
@@ -0,0 +1,56 @@
+#include "worker_pool.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+WorkerPool::WorkerPool(int workersNum_)
+{
+    _workersNum = workersNum_;
+    if( _workersNum <= 0 )
+        _workersNum = std::max(1, (int)std::thread::hardware_concurrency());
+    _threadsNum = 1;
+#ifdef _OPENMP
+    _threadsNum = std::max(1, omp_get_max_threads() / _workersNum);
+#endif
+}
+
+WorkerPool::~WorkerPool()
+{
+    join();
+}
+
+int WorkerPool::workers_num() const
+{
+    return _workersNum;
+}
+
+int WorkerPool::threads_num() const
+{
+    return _threadsNum;
+}
+
+void WorkerPool::work(std::function<void(Graph &)> work_, int worker_)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(_threadsNum);
+#endif
+    work_(_graphs[worker_]);
+}
+
+void WorkerPool::start(std::function<void(Graph &)> work_)
+{
+    std::vector<Graph>(_workersNum).swap(_graphs);
+    for( int w=0; w<_workersNum; w++ )
+        _graphs[w].set_severity_level(meerkat::mk_log::SLWarning);
+    for( int w=0; w<_workersNum; w++ )
+        _threads.push_back(std::thread(&WorkerPool::work, this, work_, w));
+}
+
+void WorkerPool::join()
+{
+    if( _threads.empty() )
+        return;
+    for( size_t w=0; w<_threads.size(); w++ )
+        _threads[w].join();
+    _threads.clear();
+}
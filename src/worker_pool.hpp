@@ -0,0 +1,65 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <functional>
+#include "graph.hpp"
+
+// WorkerPool class
+// Fixed pool of worker threads that each own a graph and an equal share of the OpenMP
+// threads. Logs of the graphs are lowered to warnings, so that the progress logs of
+// concurrent jobs do not interleave.
+class WorkerPool
+{
+private:
+    int _workersNum;
+    int _threadsNum;                    // Number of OpenMP threads of a worker.
+    std::vector<Graph> _graphs;
+    std::vector<std::thread> _threads;
+
+    /**
+     * @brief work Runs the work of a single worker with its share of the threads.
+     * @param work_   Work of the workers.
+     * @param worker_ Worker index.
+     */
+    void work(std::function<void(Graph &)> work_, int worker_);
+
+public:
+    /**
+     * @brief WorkerPool Constructor.
+     * @param workersNum_ Number of workers, 0 for one per core.
+     */
+    WorkerPool(int workersNum_);
+
+    /**
+     * @brief ~WorkerPool Destructor, waits for the workers.
+     */
+    ~WorkerPool();
+
+    /**
+     * @brief workers_num Returns the number of workers.
+     * @return Number of workers.
+     */
+    int workers_num() const;
+
+    /**
+     * @brief threads_num Returns the number of OpenMP threads of a worker.
+     * @return Number of threads.
+     */
+    int threads_num() const;
+
+    /**
+     * @brief start Creates the graphs of the workers and starts the workers.
+     * @param work_ Work of a worker, called with its graph. Workers take their jobs
+     *              from a shared queue or counter.
+     */
+    void start(std::function<void(Graph &)> work_);
+
+    /**
+     * @brief join Waits for the workers to finish and restores the logs.
+     */
+    void join();
+};
+
+#endif // WORKER_POOL_HPP